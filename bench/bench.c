@@ -0,0 +1,549 @@
+#if defined(__unix__) || defined(__APPLE__)
+    #define _POSIX_C_SOURCE 200809L
+    #define BENCH_POSIX
+#endif
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdarg.h>
+#include <time.h>
+
+#ifdef BENCH_POSIX
+    #include <sys/resource.h>
+#endif
+
+#define JSCONE_IMPLEMENTATION
+#include "jscone.h"
+
+/* count every allocation jscone makes */
+static size_t bench_allocations = 0;
+
+static void* bench_alloc(void* ctx, size_t size)
+{
+    (void)ctx;
+    bench_allocations++;
+    return malloc(size);
+}
+
+static void* bench_realloc(void* ctx, void* ptr, size_t size)
+{
+    (void)ctx;
+    bench_allocations++;
+    return realloc(ptr, size);
+}
+
+static void bench_free(void* ctx, void* ptr)
+{
+    (void)ctx;
+    free(ptr);
+}
+
+static const JsconeAllocator bench_allocator = {NULL, bench_alloc, bench_realloc, bench_free};
+
+#define BENCH_DEFAULT_RUNS 10
+#define BENCH_DEFAULT_SIZE (5u << 20) // bytes of each corpus
+#define BENCH_FIND_COUNT 100000
+#define BENCH_HUGE_SIZE ((4ull << 30) + (256u << 20)) // past 4 GiB so 32-bit offsets would wrap
+#define BENCH_HUGE_STRING (64u << 20)
+#define BENCH_HUGE_CHUNK (1u << 20)
+
+typedef struct
+{
+    char* data;
+    size_t length;
+    size_t capacity;
+} BenchText;
+
+typedef struct
+{
+    const char* name;
+    void (*generate)(BenchText* text, size_t size);
+    const char* path; // looked up by the find benchmark
+} BenchCorpus;
+
+typedef struct
+{
+    size_t bytes;
+    size_t nodes;
+    size_t allocations; // per document
+    double parse_min;   // all times in nanoseconds
+    double parse_median;
+    double find;        // per lookup
+    double free_min;
+    double free_median;
+    long peak_rss;      // kilobytes, 0 if unknown
+} BenchResult;
+
+static uint64_t bench_seed = 0x9E3779B97F4A7C15ull;
+
+/* xorshift so corpora are the same on every machine */
+static uint64_t bench_random(void)
+{
+    bench_seed ^= bench_seed << 13;
+    bench_seed ^= bench_seed >> 7;
+    bench_seed ^= bench_seed << 17;
+    return bench_seed;
+}
+
+static void bench_append(BenchText* text, const char* format, ...)
+{
+    while(JSCONE_TRUE)
+    {
+        va_list args;
+        va_start(args, format);
+        int written = vsnprintf(text->data + text->length, text->capacity - text->length, format, args);
+        va_end(args);
+
+        if(written >= 0 && (size_t)written < text->capacity - text->length)
+        {
+            text->length += (size_t)written;
+            return;
+        }
+
+        text->capacity *= 2;
+        text->data = (char*)realloc(text->data, text->capacity);
+        if(text->data == NULL)
+        {
+            fprintf(stderr, "out of memory\n");
+            exit(1);
+        }
+    }
+}
+
+static const char* bench_word(void)
+{
+    static const char* words[16] = {
+        "lorem", "ipsum", "dolor", "sit", "amet", "consectetur", "adipiscing", "elit",
+        "sed", "do", "eiusmod", "tempor", "incididunt", "ut", "labore", "magna",
+    };
+    return words[bench_random() % 16];
+}
+
+/* same shape as 5MB-min.json from https://microsoftedge.github.io/Demos/json-dummy-data/ */
+static void bench_generate_people(BenchText* text, size_t size)
+{
+    bench_append(text, "[");
+    for(size_t i = 0; text->length < size; i++)
+    {
+        bench_append(text, "%s{\"name\":\"%s %s\",\"language\":\"%s\",\"id\":\"%08llX%08llX\",\"bio\":\"%s %s %s %s %s %s %s %s.\","
+                     "\"version\":%u.%u,\"address\":{\"street\":\"%u %s street\",\"town\":\"%s\",\"postcode\":\"%c%c%u %u%c%c\"},"
+                     "\"verified\":%s,\"pets\":[\"%s\",\"%s\"]}",
+                     i ? "," : "", bench_word(), bench_word(), bench_word(),
+                     (unsigned long long)(bench_random() & 0xFFFFFFFF), (unsigned long long)(bench_random() & 0xFFFFFFFF),
+                     bench_word(), bench_word(), bench_word(), bench_word(), bench_word(), bench_word(), bench_word(), bench_word(),
+                     (unsigned int)(bench_random() % 10), (unsigned int)(bench_random() % 100),
+                     (unsigned int)(bench_random() % 1000), bench_word(), bench_word(),
+                     'A' + (int)(bench_random() % 26), 'A' + (int)(bench_random() % 26), (unsigned int)(bench_random() % 100),
+                     (unsigned int)(bench_random() % 10), 'A' + (int)(bench_random() % 26), 'A' + (int)(bench_random() % 26),
+                     bench_random() % 2 ? "true" : "false", bench_word(), bench_word());
+    }
+    bench_append(text, "]");
+}
+
+/* numbers with lots of digits, like map data */
+static void bench_generate_geojson(BenchText* text, size_t size)
+{
+    bench_append(text, "{\"type\":\"FeatureCollection\",\"features\":[");
+    for(size_t i = 0; text->length < size; i++)
+    {
+        bench_append(text, "%s{\"type\":\"Feature\",\"properties\":{\"name\":\"%s\",\"area\":%u},\"geometry\":{\"type\":\"Polygon\",\"coordinates\":[[",
+                     i ? "," : "", bench_word(), (unsigned int)(bench_random() % 100000));
+        for(int point = 0; point < 32; point++)
+        {
+            double lon = (double)(bench_random() % 360000000000ull) / 1e9 - 180.0;
+            double lat = (double)(bench_random() % 180000000000ull) / 1e9 - 90.0;
+            bench_append(text, "%s[%.12g,%.12g]", point ? "," : "", lon, lat);
+        }
+        bench_append(text, "]]}}");
+    }
+    bench_append(text, "]}");
+}
+
+/* long strings full of escape sequences and utf-8 */
+static void bench_generate_strings(BenchText* text, size_t size)
+{
+    static const char* pieces[8] = {
+        "plain text ", "\\\"quoted\\\" ", "line\\nbreak ", "tab\\tbed ", "back\\\\slash ", "caf\\u00e9 ", "\xc3\xa9t\xc3\xa9 ", "\\u2603 snow ",
+    };
+
+    bench_append(text, "[");
+    for(size_t i = 0; text->length < size; i++)
+    {
+        bench_append(text, "%s{\"title\":\"%s\",\"text\":\"", i ? "," : "", bench_word());
+        for(int piece = 0; piece < 40; piece++)
+        {
+            bench_append(text, "%s", pieces[bench_random() % 8]);
+        }
+        bench_append(text, "\"}");
+    }
+    bench_append(text, "]");
+}
+
+/* values nested hundreds of levels deep */
+static void bench_generate_deep(BenchText* text, size_t size)
+{
+    bench_append(text, "[");
+    for(size_t i = 0; text->length < size; i++)
+    {
+        bench_append(text, "%s", i ? "," : "");
+        for(int depth = 0; depth < 500; depth++)
+        {
+            bench_append(text, depth % 2 ? "[" : "{\"a\":");
+        }
+        bench_append(text, "%u", (unsigned int)(bench_random() % 1000));
+        for(int depth = 499; depth >= 0; depth--)
+        {
+            bench_append(text, depth % 2 ? "]" : "}");
+        }
+    }
+    bench_append(text, "]");
+}
+
+/* objects with many members */
+static void bench_generate_wide(BenchText* text, size_t size)
+{
+    bench_append(text, "[");
+    for(size_t i = 0; text->length < size; i++)
+    {
+        bench_append(text, "%s{", i ? "," : "");
+        for(int member = 0; member < 1000; member++)
+        {
+            bench_append(text, "%s\"key%d\":%u", member ? "," : "", member, (unsigned int)(bench_random() % 1000));
+        }
+        bench_append(text, "}");
+    }
+    bench_append(text, "]");
+}
+
+static double bench_now(void)
+{
+#ifdef BENCH_POSIX
+    struct timespec time;
+    clock_gettime(CLOCK_MONOTONIC, &time);
+    return (double)time.tv_sec * 1e9 + (double)time.tv_nsec;
+#else
+    return (double)clock() * (1e9 / CLOCKS_PER_SEC);
+#endif
+}
+
+static long bench_peak_rss(void)
+{
+#ifdef BENCH_POSIX
+    struct rusage usage;
+    if(getrusage(RUSAGE_SELF, &usage) == 0)
+    {
+    #ifdef __APPLE__
+        return usage.ru_maxrss / 1024; // bytes on macos
+    #else
+        return usage.ru_maxrss;
+    #endif
+    }
+#endif
+    return 0;
+}
+
+static size_t bench_count_nodes(JsconeNode* node)
+{
+    /* child down, parent up like jscone_free() */
+    size_t count = 0;
+    JsconeNode* top = node;
+    while(node != NULL)
+    {
+        count++;
+        if(node->child != NULL)
+        {
+            node = node->child;
+            continue;
+        }
+        while(node != top && node->next == NULL)
+        {
+            node = node->parent;
+        }
+        node = node == top ? NULL : node->next;
+    }
+    return count;
+}
+
+static int bench_compare(const void* a, const void* b)
+{
+    double x = *(const double*)a;
+    double y = *(const double*)b;
+    return (x > y) - (x < y);
+}
+
+static int bench_run(const BenchCorpus* corpus, size_t size, unsigned int runs, BenchResult* result)
+{
+    BenchText text = {.data = (char*)malloc(size + 4096), .length = 0, .capacity = size + 4096};
+    if(text.data == NULL)
+    {
+        return JSCONE_FAILURE;
+    }
+    corpus->generate(&text, size);
+
+    double* parse_times = (double*)malloc(runs * sizeof(double));
+    double* free_times = (double*)malloc(runs * sizeof(double));
+    double find_total = 0.0;
+
+    memset(result, 0, sizeof(BenchResult));
+    result->bytes = text.length;
+
+    for(unsigned int run = 0; run < runs; run++)
+    {
+        size_t allocations = bench_allocations;
+        double start = bench_now();
+        JsconeNode* root = jscone_parse(text.data, text.length);
+        parse_times[run] = bench_now() - start;
+        if(root == NULL)
+        {
+            fprintf(stderr, "%s failed to parse: %s\n", corpus->name, jscone_last_error().message);
+            free(parse_times);
+            free(free_times);
+            free(text.data);
+            return JSCONE_FAILURE;
+        }
+        result->allocations = bench_allocations - allocations;
+
+        if(run == 0)
+        {
+            result->nodes = bench_count_nodes(root);
+        }
+
+        start = bench_now();
+        for(int i = 0; i < BENCH_FIND_COUNT; i++)
+        {
+            if(jscone_find(root, corpus->path) == NULL)
+            {
+                fprintf(stderr, "%s has nothing at %s\n", corpus->name, corpus->path);
+                break;
+            }
+        }
+        find_total += bench_now() - start;
+
+        start = bench_now();
+        jscone_free(root);
+        free_times[run] = bench_now() - start;
+    }
+
+    qsort(parse_times, runs, sizeof(double), bench_compare);
+    qsort(free_times, runs, sizeof(double), bench_compare);
+    result->parse_min = parse_times[0];
+    result->parse_median = parse_times[runs / 2];
+    result->free_min = free_times[0];
+    result->free_median = free_times[runs / 2];
+    result->find = find_total / ((double)runs * BENCH_FIND_COUNT);
+    result->peak_rss = bench_peak_rss();
+
+    free(parse_times);
+    free(free_times);
+    free(text.data);
+    return JSCONE_SUCCESS;
+}
+
+static int bench_huge_string(void* user, const char* str, size_t length)
+{
+    (void)str;
+    *(size_t*)user += length;
+    return JSCONE_SUCCESS;
+}
+
+/* writes a file of long strings bigger than 4 GiB then parses it mapped and streamed */
+static int bench_huge(const char* path, int json)
+{
+    char* chunk = (char*)malloc(BENCH_HUGE_CHUNK);
+    FILE* file = fopen(path, "wb");
+    if(chunk == NULL || file == NULL)
+    {
+        fprintf(stderr, "could not write %s\n", path);
+        free(chunk);
+        return JSCONE_FAILURE;
+    }
+    memset(chunk, 'x', BENCH_HUGE_CHUNK);
+
+    /* ["xxx...", "xxx...", ..., 42] */
+    size_t size = 1;
+    size_t strings = 0;
+    fputc('[', file);
+    while(size < BENCH_HUGE_SIZE)
+    {
+        fputc('\"', file);
+        for(size_t written = 0; written < BENCH_HUGE_STRING; written += BENCH_HUGE_CHUNK)
+        {
+            fwrite(chunk, 1, BENCH_HUGE_CHUNK, file);
+        }
+        fputs("\", ", file);
+        size += BENCH_HUGE_STRING + 4;
+        strings++;
+    }
+    fputs("42]", file);
+    size += 3;
+    if(ferror(file) | fclose(file))
+    {
+        fprintf(stderr, "could not write %s\n", path);
+        free(chunk);
+        return JSCONE_FAILURE;
+    }
+
+    /* mapped, lazy strings so only the nodes are allocated */
+    int ret = JSCONE_FAILURE;
+    JsconeOptions options = {.block_size = 0, .flags = JSCONE_LAZY_STRINGS, .symbols = NULL, .max_depth = 0};
+    double start = bench_now();
+    JsconeDocument* doc = jscone_parse_file(path, &options);
+    double mapped = bench_now() - start;
+    size_t length = 0;
+    if(doc == NULL || jscone_array_len(doc->root) != strings + 1 ||
+       jscone_document_string(doc, jscone_array_get(doc->root, strings - 1), &length) == NULL || length != BENCH_HUGE_STRING ||
+       jscone_array_get(doc->root, strings)->value.num != 42.0)
+    {
+        fprintf(stderr, "huge: mapped parse failed: %s\n", jscone_last_error().message);
+        jscone_document_free(doc);
+        goto end;
+    }
+    jscone_document_free(doc);
+
+    /* streamed, then something after the root so the error offset is past 4 GiB */
+    size_t string_bytes = 0;
+    JsconeHandler handler = {.string = bench_huge_string};
+    JsconeStream* stream = jscone_stream_new(&handler, &string_bytes);
+    file = fopen(path, "rb");
+    if(stream == NULL || file == NULL)
+    {
+        fprintf(stderr, "could not read %s\n", path);
+        jscone_stream_finish(stream, NULL);
+        goto end;
+    }
+    start = bench_now();
+    size_t read;
+    int fed = JSCONE_SUCCESS;
+    while(fed == JSCONE_SUCCESS && (read = fread(chunk, 1, BENCH_HUGE_CHUNK, file)) > 0)
+    {
+        fed = jscone_stream_feed(stream, chunk, read);
+    }
+    double streamed = bench_now() - start;
+    fclose(file);
+    if(fed == JSCONE_SUCCESS)
+    {
+        fed = jscone_stream_feed(stream, " x", 2);
+    }
+    int finished = jscone_stream_finish(stream, NULL);
+    JsconeError error = jscone_last_error();
+    if(fed == JSCONE_FAILURE || string_bytes != strings * BENCH_HUGE_STRING || finished == JSCONE_SUCCESS || error.byte_offset != size + 1)
+    {
+        fprintf(stderr, "huge: streamed parse failed at byte %llu: %s\n", (unsigned long long)error.byte_offset, error.message);
+        goto end;
+    }
+
+    double mb = (double)size / (1024.0 * 1024.0);
+    if(json)
+    {
+        printf("{\"corpus\":\"huge\",\"bytes\":%llu,\"mapped_mb_per_s\":%.2f,\"streamed_mb_per_s\":%.2f,\"error_offset\":%llu}\n",
+               (unsigned long long)size, mb / (mapped / 1e9), mb / (streamed / 1e9), (unsigned long long)error.byte_offset);
+    }
+    else
+    {
+        printf("huge: %.2f GB, mapped %.1f MB/s, streamed %.1f MB/s, error found at byte %llu\n",
+               mb / 1024.0, mb / (mapped / 1e9), mb / (streamed / 1e9), (unsigned long long)error.byte_offset);
+    }
+    ret = JSCONE_SUCCESS;
+
+    end:
+    remove(path);
+    free(chunk);
+    return ret;
+}
+
+int main(int argc, char** argv)
+{
+    unsigned int runs = BENCH_DEFAULT_RUNS;
+    size_t size = BENCH_DEFAULT_SIZE;
+    int json = JSCONE_FALSE;
+    const char* only = NULL;
+    const char* huge = NULL;
+
+    for(int i = 1; i < argc; i++)
+    {
+        if(strcmp(argv[i], "--json") == 0)
+        {
+            json = JSCONE_TRUE;
+        }
+        else if(strcmp(argv[i], "--runs") == 0 && i + 1 < argc)
+        {
+            runs = (unsigned int)strtoul(argv[++i], NULL, 10);
+        }
+        else if(strcmp(argv[i], "--size") == 0 && i + 1 < argc)
+        {
+            size = (size_t)strtoul(argv[++i], NULL, 10) << 20;
+        }
+        else if(strcmp(argv[i], "--corpus") == 0 && i + 1 < argc)
+        {
+            only = argv[++i];
+        }
+        else if(strcmp(argv[i], "--huge") == 0 && i + 1 < argc)
+        {
+            huge = argv[++i];
+        }
+        else
+        {
+            fprintf(stderr, "usage: %s [--runs N] [--size MB] [--corpus NAME] [--json] [--huge FILE]\n", argv[0]);
+            return 1;
+        }
+    }
+    runs = runs == 0 ? 1 : runs;
+    jscone_set_allocator(&bench_allocator);
+
+    if(huge != NULL)
+    {
+        return bench_huge(huge, json) == JSCONE_SUCCESS ? 0 : 1;
+    }
+
+    const BenchCorpus corpora[5] = {
+        {"people", bench_generate_people, "/1000/address/town"},
+        {"geojson", bench_generate_geojson, "/features/500/geometry/coordinates/0/31/1"},
+        {"strings", bench_generate_strings, "/1000/text"},
+        {"deep", bench_generate_deep, "/10/a/0/a/0/a/0/a"},
+        {"wide", bench_generate_wide, "/100/key999"},
+    };
+
+    if(!json)
+    {
+        printf("%-8s %8s %9s %9s %9s %9s %11s %9s %9s %9s\n",
+               "corpus", "MB", "nodes", "MB/s min", "MB/s med", "ns/node", "allocs/doc", "find ns", "free ms", "peak MB");
+    }
+
+    for(int i = 0; i < 5; i++)
+    {
+        if(only != NULL && strcmp(only, corpora[i].name) != 0)
+        {
+            continue;
+        }
+
+        BenchResult result;
+        if(bench_run(&corpora[i], size, runs, &result) == JSCONE_FAILURE)
+        {
+            return 1;
+        }
+
+        /* fastest run is the least disturbed, median shows how noisy it was */
+        double mb = (double)result.bytes / (1024.0 * 1024.0);
+        if(json)
+        {
+            /* one object per line so runs can be compared by a script */
+            printf("{\"corpus\":\"%s\",\"bytes\":%lu,\"nodes\":%lu,\"runs\":%u,\"parse_ns_min\":%.0f,\"parse_ns_median\":%.0f,"
+                   "\"mb_per_s_min\":%.2f,\"mb_per_s_median\":%.2f,\"ns_per_node\":%.2f,\"allocations_per_doc\":%lu,"
+                   "\"find_ns\":%.1f,\"free_ns_min\":%.0f,\"free_ns_median\":%.0f,\"peak_rss_kb\":%ld}\n",
+                   corpora[i].name, (unsigned long)result.bytes, (unsigned long)result.nodes, runs, result.parse_min, result.parse_median,
+                   mb / (result.parse_min / 1e9), mb / (result.parse_median / 1e9), result.parse_min / (double)result.nodes,
+                   (unsigned long)result.allocations, result.find, result.free_min, result.free_median, result.peak_rss);
+        }
+        else
+        {
+            printf("%-8s %8.2f %9lu %9.1f %9.1f %9.2f %11lu %9.1f %9.2f %9.1f\n",
+                   corpora[i].name, mb, (unsigned long)result.nodes, mb / (result.parse_min / 1e9), mb / (result.parse_median / 1e9),
+                   result.parse_min / (double)result.nodes, (unsigned long)result.allocations, result.find,
+                   result.free_min / 1e6, (double)result.peak_rss / 1024.0);
+        }
+        fflush(stdout);
+    }
+
+    return 0;
+}
@@ -1,44 +1,20 @@
 #define JSCONE_IMPLEMENTATION
 #include "jscone.h"
-#include <string.h>
-#include <stdlib.h>
 #include <stdio.h>
-#include <errno.h>
-
-char* dump_file_contents(const char* filename, unsigned int* file_size_out)
-{
-    char* text;
-    FILE* file;
-    unsigned int file_size;
-
-    file = fopen(filename, "rb");
-
-    fseek(file, 0, SEEK_END);
-    file_size = ftell(file);
-
-    text = (char*)malloc(file_size + 1);
-    
-    fseek(file, 0, SEEK_SET);
-    fread(text, sizeof(char), (unsigned int)file_size, file);
-    text[file_size] = '\0';
-
-    fclose(file);
-
-    *file_size_out = file_size;
-    return text;
-}
 
 int main(void)
 {
-    char* json = NULL;
-    unsigned int file_size;
-    JsconeNode* result;
+    JsconeDocument* doc;
     
     /* from https://microsoftedge.github.io/Demos/json-dummy-data/ */
-    json = dump_file_contents("5MB-min.json", &file_size);
-    result = jscone_parse(json, file_size);
+    doc = jscone_parse_file("5MB-min.json", NULL);
+    if(doc == NULL)
+    {
+        fprintf(stderr, "could not parse 5MB-min.json: %s\n", jscone_last_error().message);
+        return 1;
+    }
 
-    JsconeNode* last_node = result->child;
+    JsconeNode* last_node = doc->root->child;
     int i = 1;
     while(last_node->next != NULL)
     {
@@ -47,9 +23,7 @@ int main(void)
     }
     printf("Person number %d:\n", i);
     jscone_print(last_node->child);
-    jscone_free(result);
-
-    free(json);
+    jscone_document_free(doc);
 
     return 0;
 }
@@ -5,14 +5,76 @@
 #include <stdio.h>
 #include <stdlib.h>
 #include <errno.h>
+#include <stdint.h>
+#include <float.h>
+#include <math.h>
+#include <locale.h>
+
+/* define JSCONE_NO_SIMD to only use the scalar structural indexer */
+#if !defined(JSCONE_NO_SIMD) && (defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2))
+    #define JSCONE_SSE2
+    #if defined(__GNUC__) || defined(__clang__)
+        #define JSCONE_AVX2 // compiled with a target attribute, only used if the cpu supports it
+    #endif
+#endif
+
+#if defined(JSCONE_IMPLEMENTATION) && defined(JSCONE_SSE2)
+    #include <emmintrin.h>
+    #ifdef JSCONE_AVX2
+        #include <immintrin.h>
+    #endif
+#endif
+
+#if defined(JSCONE_IMPLEMENTATION) && defined(_MSC_VER)
+    #include <intrin.h>
+#endif
+
+/* define JSCONE_NO_MMAP to read files with stdio in jscone_parse_file() instead of mapping them */
+#if !defined(JSCONE_NO_MMAP) && (defined(__unix__) || defined(__APPLE__))
+    #define JSCONE_MMAP
+#endif
+
+#if defined(JSCONE_IMPLEMENTATION) && defined(JSCONE_MMAP)
+    #include <sys/mman.h>
+    #include <sys/stat.h>
+    #include <fcntl.h>
+    #include <unistd.h>
+#endif
+
+/* define JSCONE_THREADS (and link with -pthread) for jscone_parse_many() to use more than one thread */
+#ifdef JSCONE_THREADS
+    #include <pthread.h>
+    #include <unistd.h>
+#endif
+
+/* jscone_last_error() is kept per thread where the compiler can */
+#if defined(__STDC_VERSION__) && __STDC_VERSION__ >= 201112L && !defined(__STDC_NO_THREADS__)
+    #define JSCONE_THREAD_LOCAL _Thread_local
+#elif defined(__GNUC__) || defined(__clang__)
+    #define JSCONE_THREAD_LOCAL __thread
+#elif defined(_MSC_VER)
+    #define JSCONE_THREAD_LOCAL __declspec(thread)
+#else
+    #define JSCONE_THREAD_LOCAL
+#endif
 
 #ifdef __cplusplus
 extern "C" {
 #endif
 
-/* change as you wish */
+/* change as you wish (or define before including), used when no JsconeAllocator is set, see jscone_set_allocator() */
+#ifndef JSCONE_ALLOC
 #define JSCONE_ALLOC malloc
+#endif
+#ifndef JSCONE_STR_ALLOC
 #define JSCONE_STR_ALLOC JSCONE_ALLOC
+#endif
+#ifndef JSCONE_REALLOC
+#define JSCONE_REALLOC realloc
+#endif
+#ifndef JSCONE_FREE
+#define JSCONE_FREE free
+#endif
 
 enum
 {
@@ -28,20 +90,79 @@ typedef enum
     JSCONE_STRING,
     JSCONE_OBJECT,
     JSCONE_ARRAY,
+    JSCONE_INT, // integer too big for a double to hold exactly
     JSCONE_TYPE_COUNT, // amount of types
 } JsconeType;
 
+/**
+ * where jscone gets its memory from, see jscone_set_allocator()
+ * realloc and free are given pointers from this allocator only, never NULL
+ */
+typedef struct
+{
+    void* ctx; // passed to each function
+    void* (*alloc)(void* ctx, size_t size);
+    void* (*realloc)(void* ctx, void* ptr, size_t size);
+    void (*free)(void* ctx, void* ptr);
+} JsconeAllocator;
+
+typedef enum
+{
+    JSCONE_ERROR_NONE,
+    JSCONE_ERROR_MEMORY,
+    JSCONE_ERROR_FILE,
+    JSCONE_ERROR_SYNTAX,    // unexpected, missing or extra characters
+    JSCONE_ERROR_STRING,    // unterminated string, control character or invalid escape sequence
+    JSCONE_ERROR_NUMBER,
+    JSCONE_ERROR_LITERAL,   // not true/false/null
+    JSCONE_ERROR_DEPTH,     // nested deeper than the max depth
+    JSCONE_ERROR_NOT_FOUND, // nothing at path given to jscone_find()
+    JSCONE_ERROR_CALLBACK,  // a callback stopped parsing
+    JSCONE_ERROR_UTF8,      // invalid utf-8, only checked with JSCONE_VALIDATE_UTF8
+} JsconeErrorCode;
+
+typedef struct
+{
+    JsconeErrorCode code;
+    size_t byte_offset;  // from the start of the json (or path) where it went wrong, 0 if it isn't about a position
+    const char* message; // never NULL, static so it doesn't need freeing
+} JsconeError;
+
+/* see jscone_set_log() */
+typedef void (*JsconeLogFunc)(void* user, const JsconeError* error);
+
+/* string that has not been decoded yet, points into the json (see JSCONE_LAZY_STRINGS) */
+typedef struct
+{
+    const char* str;
+    size_t length;
+} JsconeSlice;
+
 typedef union
 {
     char* str;
     double num;
+    int64_t integer;
     unsigned char bool;
+    JsconeSlice* slice; // only if node has JSCONE_NODE_RAW flag
+    struct JsconeMembers* members; // only if object node has JSCONE_NODE_HASHED flag
+    struct JsconeNode** elements;  // only if array node has JSCONE_NODE_INDEXED flag
 } JsconeVal;
 
+/* JsconeNode flags */
+#define JSCONE_NODE_RAW      0x1  // value is a slice of the json, use jscone_document_string() to get it
+#define JSCONE_NODE_ESCAPED  0x2  // raw string has escape sequences and has to be decoded
+#define JSCONE_NODE_HASHED   0x4  // object has a hash table of its children's names (see jscone_get_member())
+#define JSCONE_NODE_ARENA    0x8  // node belongs to a document so can't own malloc'd memory
+#define JSCONE_NODE_INTERNED 0x10 // name is owned by a JsconeSymbolTable, see jscone_node_symbol()
+#define JSCONE_NODE_INDEXED  0x20 // array has its children in a vector (see jscone_array_get())
+#define JSCONE_NODE_TREE     0x40 // root node that remembers the allocator its tree was made with (see jscone_set_allocator())
+
 typedef struct JsconeNode
 {
     struct JsconeNode* parent;
     struct JsconeNode* child;
+    struct JsconeNode* last; // last child so adding one doesn't go through the rest
 
     /* other children of parent node */
     struct JsconeNode* next;
@@ -49,9 +170,180 @@ typedef struct JsconeNode
 
     const char* name;
     JsconeType type;
+    unsigned int flags; // JSCONE_NODE_*
+    size_t count;       // number of children
     JsconeVal value;
 } JsconeNode;
 
+/* chunk of memory for a document's nodes and strings, data follows the header */
+typedef struct JsconeArenaBlock
+{
+    struct JsconeArenaBlock* next;
+    size_t size;
+    size_t used;
+} JsconeArenaBlock;
+
+typedef struct
+{
+    JsconeArenaBlock* head; // block currently being allocated from, older blocks follow
+    size_t block_size;      // size of the next block, doubles every time a block fills up
+    const JsconeAllocator* allocator; // blocks come from the allocator set when the arena was made
+} JsconeArena;
+
+/* JsconeOptions flags */
+#define JSCONE_LAZY_STRINGS 0x1 // keep string values as slices of the json and only decode them when asked for, json must outlive the document
+#define JSCONE_HASH_MEMBERS 0x2 // give big objects a hash table of their children while parsing so jscone_get_member() is O(1)
+#define JSCONE_VALIDATE_UTF8 0x4 // fail on invalid utf-8, checked 64 bytes at a time while finding tokens
+
+/* names shared between documents, see jscone_symbols_new() */
+typedef struct JsconeSymbolTable JsconeSymbolTable;
+
+typedef struct
+{
+    size_t block_size;  // size of first arena block, 0 to guess from json length
+    unsigned int flags; // JSCONE_LAZY_STRINGS, JSCONE_HASH_MEMBERS, JSCONE_VALIDATE_UTF8
+    JsconeSymbolTable* symbols; // if not NULL names point into this instead of being copied into the document, must outlive it
+    unsigned int max_depth;     // objects/arrays nested deeper than this fail to parse, 0 for the default of 1024
+} JsconeOptions;
+
+typedef struct
+{
+    JsconeNode* root;
+    JsconeArena arena; // owns every node and string in the document
+    char* file;        // json from jscone_parse_file(), NULL otherwise
+    size_t file_size;
+} JsconeDocument;
+
+/* parses one document after another into the same memory, see jscone_context_new() */
+typedef struct JsconeContext JsconeContext;
+
+/**
+ * flat alternative to the node tree, one contiguous array of 64-bit entries
+ * top 8 bits are a tag (see JSCONE_TAPE_*), bottom 56 bits are a payload
+ */
+typedef struct
+{
+    uint64_t* entries;
+    size_t length;
+    size_t capacity;
+
+    /* strings are stored as a size_t length then the characters and a \0 */
+    char* strings;
+    size_t strings_length;
+    size_t strings_capacity;
+
+    const JsconeAllocator* allocator; // set when it was made, frees it
+
+    /* used while parsing */
+    size_t open;           // 1 + index of innermost container that hasn't ended, 0 if none
+    unsigned char keyed;   // a key was just pushed so the next value belongs to it
+} JsconeTape;
+
+/* growable output of jscone_write(), zero it before first use */
+typedef struct
+{
+    char* data;    // \0 terminated
+    size_t length; // not counting \0, set to 0 to reuse the buffer
+    size_t capacity;
+} JsconeBuffer;
+
+typedef struct
+{
+    unsigned int indent; // spaces for each level, 0 for compact output with no whitespace
+} JsconeWriteOptions;
+
+#define JSCONE_TAPE_ROOT 0
+#define JSCONE_TAPE_NONE ((size_t)-1)
+
+/* 16 bytes, children of an object/array are next to each other instead of linked */
+typedef struct
+{
+    uint64_t value; // double/int64_t bits, 1 for true, offset of a string, or first child (low 32 bits) and count (high 32 bits)
+    uint32_t name;  // offset of the name in strings, JSCONE_COMPACT_NO_NAME if not inside an object
+    uint32_t type;  // JsconeType
+} JsconeCompactNode;
+
+/**
+ * read only tree in one array of nodes linked by 32-bit indexes instead of pointers
+ * use the jscone_compact_* functions to read it, values are referred to by their index like in a tape
+ */
+typedef struct
+{
+    JsconeCompactNode* nodes;
+    size_t count;
+    char* strings; // stored like a tape's strings
+    size_t strings_length;
+    const JsconeAllocator* allocator; // set when it was made, frees it
+} JsconeCompact;
+
+#define JSCONE_COMPACT_ROOT 0
+#define JSCONE_COMPACT_NONE ((size_t)-1)
+#define JSCONE_COMPACT_NO_NAME 0xFFFFFFFFu
+
+/**
+ * position of a value in the json for on-demand parsing (see jscone_cursor_*), nothing is allocated
+ * copy it to remember a position, moving a copy does not affect the original
+ */
+typedef struct
+{
+    const char* json;
+    size_t length;
+    size_t first;      // first character of the value the cursor is on
+    size_t end;        // 1 past the last character of the value's first token
+    size_t name_first; // the value's key (with quotes) if it is inside an object, otherwise name_first == name_end
+    size_t name_end;
+    unsigned char in_object;
+} JsconeCursor;
+
+/**
+ * callbacks for jscone_parse_events(), any of them can be NULL
+ * return JSCONE_SUCCESS to carry on or JSCONE_FAILURE to stop parsing
+ * strings are only valid until the callback returns
+ */
+typedef struct
+{
+    int (*start_object)(void* user);
+    int (*end_object)(void* user);
+    int (*start_array)(void* user);
+    int (*end_array)(void* user);
+    int (*key)(void* user, const char* name, size_t length);
+    int (*string)(void* user, const char* str, size_t length);
+    int (*number)(void* user, double num);
+    int (*integer)(void* user, int64_t integer); // JSCONE_INT values, given to number() instead if NULL
+    int (*boolean)(void* user, unsigned char value);
+    int (*null)(void* user);
+} JsconeHandler;
+
+/* one name in a JsconePath */
+typedef struct
+{
+    char* name; // decoded like names in jscone_find()
+    size_t length;
+    uint64_t hash;
+    unsigned int symbol; // set by jscone_path_intern(), 0 if not
+    size_t index;        // name as an array index, JSCONE_PATH_NO_INDEX if it is not a number
+} JsconePathSegment;
+
+#define JSCONE_PATH_NO_INDEX ((size_t)-1)
+
+/* path split up ahead of time by jscone_path_compile() so it can be looked up many times */
+typedef struct
+{
+    JsconePathSegment* segments;
+    size_t count;
+    unsigned char relative; // path didn't start with /, so first name is searched for in the node given and its siblings
+} JsconePath;
+
+/* incremental parser, see jscone_stream_new() */
+typedef struct JsconeStream JsconeStream;
+
+/**
+ * called by jscone_parse_many() for each document in order
+ * root is only valid until the callback returns and must not be freed
+ * return JSCONE_SUCCESS to carry on or JSCONE_FAILURE to stop
+ */
+typedef int (*JsconeManyFunc)(void* user, JsconeNode* root);
+
 /**
  * exposed functions
  */
@@ -60,860 +352,6328 @@ typedef struct JsconeNode
  * @param  length:  length of json string
  * @returns         root node/object
  */
-JsconeNode* jscone_parse(const char* json, unsigned int length);
+JsconeNode* jscone_parse(const char* json, size_t length);
 
 /**
  * @brief    finds node at specified path from the current node e.g "/world/player_data"
  * @note     use backslash \ to escape forward slashes / if they are contained within names
+ * @note     names inside arrays have to be indexes e.g. "/items/3", anything else is not found
  * @note     if you also want to search in the current node and it's siblings first omit the first slash e.g. "world/player_data"
  * @returns  pointer to node at path
  */
 JsconeNode* jscone_find(JsconeNode* node, const char* path);
 
 /**
- * @brief  frees output from jscone_parse. call when you are done with it.
- * @note   pass any node from the output, the function will free them all
+ * @brief    finds child of object with the name key
+ * @note     objects with lots of children use a hash table, for jscone_parse() trees it is made the first time a lookup
+ *           goes past JSCONE_HASH_MIN_MEMBERS children so don't look up in one tree from multiple threads at once,
+ *           documents need JSCONE_HASH_MEMBERS for it
+ * @param    length:  length of key
+ * @returns  child node, NULL if not found or object is not an object
  */
-void jscone_free(JsconeNode* node);
+JsconeNode* jscone_get_member(JsconeNode* object, const char* key, size_t length);
 
 /**
- * @brief  prints out tree of specific node
- * @note   slow, should be used for debugging purposes only
+ * @brief    gets child at index of array in O(1)
+ * @note     jscone_parse() arrays that were changed after parsing get their vector made again here
+ *           so don't use it from multiple threads at once on them
+ * @returns  child node, NULL if index is out of range or arr is not an array
  */
-void jscone_print(JsconeNode* node);
+JsconeNode* jscone_array_get(JsconeNode* arr, size_t index);
 
+/**
+ * @returns  number of children of arr, 0 if it is not an array
+ */
+size_t jscone_array_len(const JsconeNode* arr);
 
 /**
- * internal types and functions
+ * @brief    splits path up for jscone_path_eval(), takes the same paths as jscone_find()
+ * @returns  compiled path, NULL on failure
  */
+JsconePath* jscone_path_compile(const char* path);
 
-#define JSCONE_TRUE 1
-#define JSCONE_FALSE 0 
+/**
+ * @brief    finds node at compiled path from node like jscone_find()
+ * @note     never allocates or prints anything, uses hash tables objects already have (see jscone_get_member()) but doesn't make them
+ * @returns  pointer to node at path, NULL if there isn't one
+ */
+JsconeNode* jscone_path_eval(JsconeNode* node, const JsconePath* path);
 
-/* for jscone_print() */
-#define JSCONE_MAX_INDENT 20
-#define JSCONE_INDENT_SIZE 4
+/**
+ * @brief    adds path's names to symbols so jscone_path_eval() compares symbols instead of names
+ * @note     the path must then only be used on nodes from jscone_parse_document() with the same symbols
+ * @returns  JSCONE_SUCCESS, JSCONE_FAILURE if out of memory
+ */
+int jscone_path_intern(JsconePath* path, JsconeSymbolTable* symbols);
 
-#define JSCONE_PARSER_NEXT_TOKEN(parser) if(jscone_lexer_next_token(&((parser)->lexer)) == JSCONE_FAILURE) { return JSCONE_FAILURE; }
-#define JSCONE_PARSER_TOKEN_LENGTH(parser) ((parser)->lexer.curr.end - (parser)->lexer.curr.first)
-#define JSCONE_PARSER_GET_FIRST_CHAR(parser) ((parser)->lexer.json[(parser)->lexer.curr.first])
-#define JSCONE_PARSER_GET_LAST_CHAR(parser) ((parser)->lexer.json[(parser)->lexer.curr.end - 1])
+/**
+ * @brief  frees output from jscone_path_compile()
+ */
+void jscone_path_free(JsconePath* path);
 
-#define JSCONE_ERROR(...) do { fprintf(stderr, "[JSCONE]: "); fprintf(stderr, __VA_ARGS__); } while(0)
-#define JSCONE_LEXER_ERROR(lexer, ...) do { JSCONE_ERROR("on line %u\n", (lexer)->line_num); fprintf(stderr, __VA_ARGS__); } while(0)
-#define JSCONE_PARSER_ERROR(parser, ...) do { JSCONE_ERROR("on line %u\n", ((parser)->lexer.line_num)); fprintf(stderr, __VA_ARGS__); } while(0)
-#define JSCONE_EXPECT_CHAR(parser, char, expected, ...) \
-if(char != expected)                               \
-{                                                  \
-    JSCONE_PARSER_ERROR((parser), "expected char %c: ", expected); \
-    fprintf(stderr, __VA_ARGS__);                  \
-    return JSCONE_FAILURE;                         \
-}
-#define JSCONE_EXPECT_FIRST_CHAR(parser, expected, ...) JSCONE_EXPECT_CHAR((parser), JSCONE_PARSER_GET_FIRST_CHAR(parser), expected, __VA_ARGS__)
-#define JSCONE_EXPECT_LAST_CHAR(parser, expected, ...) JSCONE_EXPECT_CHAR((parser), JSCONE_PARSER_GET_LAST_CHAR(parser), expected, __VA_ARGS__)
+/**
+ * @brief    creates a table that names are interned into when it is given to jscone_parse_document() in JsconeOptions
+ * @note     every name is only stored once however many documents use it, and gets a symbol number from 1 up
+ *           not thread safe, so documents using the same table can't be parsed at the same time
+ * @returns  symbol table, NULL on failure
+ */
+JsconeSymbolTable* jscone_symbols_new(void);
 
-typedef struct
-{
-    unsigned int first; // first character of token in json string (index)
-    unsigned int end;   // 1 past last character
-} JsconeToken;
+/**
+ * @brief    gets the symbol of name without adding it
+ * @returns  symbol, 0 if name is not in the table
+ */
+unsigned int jscone_symbols_find(const JsconeSymbolTable* symbols, const char* name, size_t length);
 
-typedef struct
-{
-    const char* json;
-    unsigned int length;
-    JsconeToken curr;
-    unsigned int line_num; // for error printing
-} JsconeLexer;
+/**
+ * @brief  frees a symbol table, documents that used it must be freed first
+ */
+void jscone_symbols_free(JsconeSymbolTable* symbols);
 
-typedef struct
-{
-    JsconeLexer lexer;
-    JsconeNode* curr_node;
-} JsconeParser;
+/**
+ * @returns  symbol of node's name, 0 if the node was not parsed with a symbol table
+ */
+unsigned int jscone_node_symbol(const JsconeNode* node);
 
-int jscone_parser_parse_value(JsconeParser* parser, const char* name);
-int jscone_parser_parse_object(JsconeParser* parser, const char* name);
-int jscone_parser_parse_array(JsconeParser* parser, const char* name);
-int jscone_parser_parse_number(JsconeParser* parser, const char* name);
-int jscone_parser_parse_enum(JsconeParser* parser, const char* name);
-int jscone_parser_parse_string(JsconeParser* parser, const char* name);
-char* jscone_parser_parse_name(JsconeParser* parser);
-char* jscone_parser_get_string(JsconeParser* parser);
+/**
+ * @brief  frees output from jscone_parse. call when you are done with it.
+ * @note   pass any node from the output, the function will free them all
+ */
+void jscone_free(JsconeNode* node);
 
 /**
- * @note if first == end then EOF
+ * @brief    parses json into a document where all nodes, names and strings are allocated from a few big blocks
+ * @param    options:  can be NULL for defaults
+ * @note     nodes in the document must not be passed to jscone_free(), use jscone_document_free()
+ * @returns  document with root node/object, NULL on failure
  */
-int jscone_lexer_next_token(JsconeLexer* lexer);
-int jscone_lexer_lex_string(JsconeLexer* lexer);
+JsconeDocument* jscone_parse_document(const char* json, size_t length, const JsconeOptions* options);
 
+/**
+ * @brief    same as jscone_parse_document() but names and strings are decoded in place inside json, so none are allocated
+ * @note     json is modified and has to stay alive until the document is freed
+ * @returns  document with root node/object, NULL on failure
+ */
+JsconeDocument* jscone_parse_insitu(char* json, size_t length);
 
-JsconeNode* jscone_find_name_in_siblings(JsconeParser* parser, const char* name);
+/**
+ * @brief    maps (or reads if it can't) the file at path and parses it like jscone_parse_document()
+ * @note     the file stays mapped until the document is freed, so JSCONE_LAZY_STRINGS strings point straight into it
+ * @param    options:  can be NULL
+ * @returns  document with root node/object, NULL on failure
+ */
+JsconeDocument* jscone_parse_file(const char* path, const JsconeOptions* options);
 
-JsconeNode* jscone_node_create(JsconeNode* parent, JsconeType type, JsconeVal value);
-void jscone_node_free(JsconeNode* node);
-void jscone_node_print(JsconeNode* node, unsigned int indent);
+/**
+ * @brief    gets value of a string node, decoding it first if it was parsed with JSCONE_LAZY_STRINGS
+ * @param    length:  set to length of string if not NULL
+ * @note     decoded strings are cached in the document, strings without escapes are returned as they are in the json so are not \0 terminated
+ * @returns  string, NULL if node is not a string or has an invalid escape sequence
+ */
+const char* jscone_document_string(JsconeDocument* doc, JsconeNode* node, size_t* length);
 
+/**
+ * @brief  frees a document and every node in it, only frees the arena blocks so it is O(number of blocks)
+ */
+void jscone_document_free(JsconeDocument* doc);
 
+/**
+ * @brief    makes a context for parsing lots of documents one after another without allocating for each one
+ * @param    options:  used for every document, can be NULL for defaults
+ * @note     keeps using the allocator set for this thread when it was made, use one context per thread
+ * @returns  context, NULL on failure
+ */
+JsconeContext* jscone_context_new(const JsconeOptions* options);
 
-#ifdef JSCONE_IMPLEMENTATION
+/**
+ * @brief    parses json like jscone_parse_document() but reuses the context's memory, once it is big enough nothing is allocated
+ * @note     the document belongs to the context and is only valid until the next parse, don't pass it to jscone_document_free()
+ * @returns  document with root node/object, NULL on failure
+ */
+JsconeDocument* jscone_context_parse(JsconeContext* context, const char* json, size_t length);
 
-static const char* jscone_get_type_name(JsconeType type);
-unsigned char jscone_parse_escape_sequence(JsconeParser* parser, unsigned int offset, char* bytes);
-unsigned char jscone_codepoint_to_utf8(char* bytes, const char* codepoint_str);
+/**
+ * @brief  frees a context along with the last document parsed with it
+ */
+void jscone_context_free(JsconeContext* context);
 
 /**
- * exposed functions
+ * @brief    parses json into a tape (see JsconeTape), values are referred to by their index in the tape
+ * @note     root is at JSCONE_TAPE_ROOT, functions that return indexes return JSCONE_TAPE_NONE if there is nothing there
+ * @returns  tape, NULL on failure
  */
+JsconeTape* jscone_parse_tape(const char* json, size_t length);
 
-JsconeNode* jscone_parse(const char* json, unsigned int length)
-{
-    /* top object */
-    JsconeParser parser = {
-        .lexer = {
-            .json = json,
-            .length = length,
-            .curr = {.first = 0, .end = 0},
-            .line_num = 1,
-        },
-        .curr_node = NULL,
-    };
+/**
+ * @brief  frees output from jscone_parse_tape
+ */
+void jscone_tape_free(JsconeTape* tape);
 
-    /* go to first token */
-    if(jscone_lexer_next_token(&parser.lexer) == JSCONE_FAILURE)
-    {
-        JSCONE_ERROR("could not lex first token\n");
-        return NULL;
-    }
-    
-    if(JSCONE_PARSER_GET_FIRST_CHAR(&parser) == '{')
-    {
-        if(jscone_parser_parse_object(&parser, NULL) == JSCONE_FAILURE) // will return the root node
-        {
-            jscone_free(parser.curr_node);
-            return NULL;
-        }
-    }
-    else if(JSCONE_PARSER_GET_FIRST_CHAR(&parser) == '[')
-    {
-        if(jscone_parser_parse_array(&parser, NULL) == JSCONE_FAILURE) // will return the root node
-        {
-            jscone_free(parser.curr_node);
-            return NULL;
-        }
-    }
-    else
-    {
-        JSCONE_ERROR("first character not { or [\n");
-        return NULL;
-    }
+JsconeType jscone_tape_type(const JsconeTape* tape, size_t index);
 
-    /* check for extra characters after json end */
-    if(parser.lexer.curr.first != parser.lexer.curr.end)
-    {
-        jscone_lexer_next_token(&parser.lexer);
+/**
+ * @returns  name of a value inside an object, otherwise NULL
+ */
+const char* jscone_tape_name(const JsconeTape* tape, size_t index);
 
-        /* if multiple characters beyond end of json */
-        if(parser.lexer.curr.first != parser.lexer.curr.end)
-        {
-            jscone_free(parser.curr_node);
-            JSCONE_PARSER_ERROR(&parser, "extra characters after JSON end\n");
-            return NULL;
-        }
+/**
+ * @param    length:  set to length of string if not NULL
+ */
+const char* jscone_tape_string(const JsconeTape* tape, size_t index, size_t* length);
+double jscone_tape_num(const JsconeTape* tape, size_t index);
+int64_t jscone_tape_int(const JsconeTape* tape, size_t index);
+unsigned char jscone_tape_bool(const JsconeTape* tape, size_t index);
 
-        /* only 1 character beyond end of token or just whitespace */
-        switch(parser.lexer.json[parser.lexer.curr.first])
-        {
-            case '\r': case '\n': case '\t': case ' ':
-                return parser.curr_node; // allow whitespace
-            default:
-                JSCONE_PARSER_ERROR(&parser, "extra characters after JSON end\n");
-                jscone_free(parser.curr_node);
-                return NULL;
-        }
-    }
+/**
+ * @returns  index of first value in an object/array
+ */
+size_t jscone_tape_child(const JsconeTape* tape, size_t index);
 
-    return parser.curr_node;
-}
+/**
+ * @returns  index of the value after this one in the same object/array
+ */
+size_t jscone_tape_next(const JsconeTape* tape, size_t index);
 
-JsconeNode* jscone_find(JsconeNode* node, const char* path)
-{
-    if(node == NULL || path == NULL)
-    {
-        return NULL;
-    }
+/**
+ * @brief  same as jscone_find() but for tapes
+ */
+size_t jscone_tape_find(const JsconeTape* tape, size_t index, const char* path);
 
-    JsconeParser parser = {
-        .lexer = {
-            .curr = {.first = (unsigned int)0, .end = (unsigned int)0},
-            .json = path,
-            .length = (unsigned int)strlen(path),
-        },
-        .curr_node = node,
-    };
-    
-    /* skip current node and start search with children */
-    if(path[0] == '/')
-    {
-        if(node->child == NULL)
-        {
-            return NULL;
-        }
+/**
+ * @brief    parses json into compact nodes (see JsconeCompact), several times smaller than a JsconeNode tree
+ * @note     root is at JSCONE_COMPACT_ROOT, functions that return indexes return JSCONE_COMPACT_NONE if there is nothing there
+ * @note     strings have to fit in 4GB and there can't be more than 2^32 values
+ * @returns  compact nodes, NULL on failure
+ */
+JsconeCompact* jscone_parse_compact(const char* json, size_t length);
 
-        parser.curr_node = node->child;
+/**
+ * @brief  frees output from jscone_parse_compact
+ */
+void jscone_compact_free(JsconeCompact* compact);
 
-        /* skip past first / */
-        path++;
+JsconeType jscone_compact_type(const JsconeCompact* compact, size_t index);
+
+/**
+ * @returns  name of a value inside an object, otherwise NULL
+ */
+const char* jscone_compact_name(const JsconeCompact* compact, size_t index);
+
+/**
+ * @param    length:  set to length of string if not NULL
+ */
+const char* jscone_compact_string(const JsconeCompact* compact, size_t index, size_t* length);
+double jscone_compact_num(const JsconeCompact* compact, size_t index);
+int64_t jscone_compact_int(const JsconeCompact* compact, size_t index);
+unsigned char jscone_compact_bool(const JsconeCompact* compact, size_t index);
+
+/**
+ * @returns  number of values in an object/array, 0 for anything else
+ */
+size_t jscone_compact_len(const JsconeCompact* compact, size_t index);
+
+/**
+ * @brief    O(1) for objects and arrays since their values are next to each other
+ * @returns  index of the nth value in an object/array
+ */
+size_t jscone_compact_child(const JsconeCompact* compact, size_t index, size_t n);
+
+/**
+ * @brief  same as jscone_find() but for compact nodes, names are looked for in index's children (leading / is optional)
+ */
+size_t jscone_compact_find(const JsconeCompact* compact, size_t index, const char* path);
+
+/**
+ * @brief    parses json and calls handler for each value as it is reached instead of building anything
+ * @note     memory used only grows with nesting depth and the longest string
+ * @param    user:  passed to every callback
+ * @returns  JSCONE_SUCCESS, JSCONE_FAILURE if json is invalid or a callback stopped it
+ */
+int jscone_parse_events(const char* json, size_t length, const JsconeHandler* handler, void* user);
+
+/**
+ * @brief    parses many json documents one after the other (e.g. json lines) across multiple threads
+ * @note     only uses one thread unless JSCONE_THREADS is defined
+ * @param    threads:   amount of threads to use, 0 for one per cpu
+ * @param    callback:  called with each document in order
+ * @returns  JSCONE_SUCCESS, JSCONE_FAILURE if a document is invalid (documents before it are still given) or callback stopped it
+ */
+int jscone_parse_many(const char* json, size_t length, unsigned int threads, JsconeManyFunc callback, void* user);
+
+/**
+ * @brief    parses one big document by splitting the values inside its root object/array between threads
+ * @note     only uses one thread unless JSCONE_THREADS is defined
+ * @param    options:  flags are used like jscone_parse_document() but symbols aren't, can be NULL
+ * @param    threads:  amount of threads to use, 0 for one per cpu
+ * @returns  document like jscone_parse_document(), NULL on failure
+ */
+JsconeDocument* jscone_parse_parallel(const char* json, size_t length, const JsconeOptions* options, unsigned int threads);
+
+/**
+ * @brief    creates a parser that is given the json a chunk at a time with jscone_stream_feed()
+ * @param    handler:  callbacks like jscone_parse_events(), if NULL a node tree is built instead
+ * @returns  stream, NULL on failure
+ */
+JsconeStream* jscone_stream_new(const JsconeHandler* handler, void* user);
+
+/**
+ * @brief    parses the next part of the json, chunks can be split anywhere (even inside strings and numbers)
+ * @note     chunk is not used after this returns
+ * @returns  JSCONE_FAILURE if json is invalid, later calls will also fail
+ */
+int jscone_stream_feed(JsconeStream* stream, const char* chunk, size_t length);
+
+/**
+ * @brief    checks the json is complete then frees the stream
+ * @param    root:  set to root node if stream is building a tree, can be NULL
+ * @returns  JSCONE_SUCCESS or JSCONE_FAILURE
+ */
+int jscone_stream_finish(JsconeStream* stream, JsconeNode** root);
+
+/**
+ * @brief    puts cursor on the root value of the json, nothing else is read until the cursor is moved
+ * @note     only the parts of the json the cursor passes over are checked, so it can be invalid elsewhere
+ * @returns  JSCONE_SUCCESS or JSCONE_FAILURE
+ */
+int jscone_cursor_init(JsconeCursor* cursor, const char* json, size_t length);
+
+/**
+ * @note  numbers are always JSCONE_NUM, use jscone_cursor_get_int() for exact integers
+ */
+JsconeType jscone_cursor_type(const JsconeCursor* cursor);
+
+/**
+ * @brief    moves cursor to the value of a field in the object it is on, other fields are skipped without being parsed
+ * @returns  JSCONE_FAILURE if the cursor is not on an object or there is no such field, cursor does not move
+ */
+int jscone_cursor_find_field(JsconeCursor* cursor, const char* name);
+
+/**
+ * @brief    same as jscone_find() but for cursors, always searches inside the value the cursor is on
+ * @returns  JSCONE_FAILURE if there is nothing at path, cursor does not move
+ */
+int jscone_cursor_find(JsconeCursor* cursor, const char* path);
+
+/**
+ * @brief    moves cursor to the first value in the object/array it is on
+ * @returns  JSCONE_FAILURE if the cursor is not on an object/array or it is empty, cursor does not move
+ */
+int jscone_cursor_first_element(JsconeCursor* cursor);
+
+/**
+ * @brief    skips the value the cursor is on and moves to the next one in the same object/array
+ * @returns  JSCONE_FAILURE at the end of the object/array, cursor does not move
+ */
+int jscone_cursor_next_element(JsconeCursor* cursor);
+
+/**
+ * @param    length:  set to length of name if not NULL
+ * @returns  name of a value inside an object (not \0 terminated, escape sequences are left in), otherwise NULL
+ */
+const char* jscone_cursor_name(const JsconeCursor* cursor, size_t* length);
+
+/**
+ * @returns  JSCONE_FAILURE if the cursor is not on the right type of value
+ */
+int jscone_cursor_get_double(const JsconeCursor* cursor, double* num);
+int jscone_cursor_get_int(const JsconeCursor* cursor, int64_t* integer);
+int jscone_cursor_get_bool(const JsconeCursor* cursor, unsigned char* value);
+
+/**
+ * @returns  decoded string which has to be freed with jscone_string_free(), NULL if the cursor is not on a valid string
+ */
+char* jscone_cursor_get_string(const JsconeCursor* cursor);
+
+/**
+ * @brief  frees a string from jscone_cursor_get_string()
+ */
+void jscone_string_free(char* str);
+
+/**
+ * @brief  prints out tree of specific node
+ * @note   slow, should be used for debugging purposes only
+ */
+void jscone_print(JsconeNode* node);
+
+/**
+ * @brief    writes node (not its name or siblings) and everything inside it as json on the end of buf
+ * @note     numbers are written with as few digits as parse back to the same double, NaN and infinity become null
+ * @param    options:  can be NULL for compact output
+ * @returns  JSCONE_SUCCESS, JSCONE_FAILURE if out of memory
+ */
+int jscone_write(const JsconeNode* node, JsconeBuffer* buf, const JsconeWriteOptions* options);
+
+/**
+ * @brief    same as jscone_write() but into a file which is created or overwritten
+ * @returns  JSCONE_SUCCESS, JSCONE_FAILURE if the file could not be written
+ */
+int jscone_write_file(const JsconeNode* node, const char* path, const JsconeWriteOptions* options);
+
+/**
+ * @brief  frees memory of a buffer from jscone_write(), it can be used again after
+ */
+void jscone_buffer_free(JsconeBuffer* buf);
+
+/**
+ * @brief  makes every allocation and free on this thread go through allocator instead of malloc/realloc/free
+ * @note   trees, documents, tapes, compact nodes and streams remember the allocator they were made with and always use it,
+ *         anything else (paths, symbol tables, buffers, strings) has to be freed with the same allocator set
+ *         jscone_parse_many() and jscone_parse_parallel() give it to their worker threads
+ * @param  allocator:  must outlive everything allocated with it, NULL to go back to malloc
+ */
+void jscone_set_allocator(const JsconeAllocator* allocator);
+
+/**
+ * @brief    gets what went wrong in the last call that failed on this thread
+ * @note     parsing a document clears it first, jscone_parse_many() and jscone_parse_parallel() give the first document/part that failed
+ * @returns  error, code is JSCONE_ERROR_NONE if nothing has failed
+ */
+JsconeError jscone_last_error(void);
+
+/**
+ * @brief    works out the line and column (both from 1) of an error by going through json up to it
+ * @note     only call it once something has failed, parsing itself doesn't count lines
+ * @param    json:  the same json that was parsed
+ * @returns  JSCONE_SUCCESS, JSCONE_FAILURE if the error's offset is past length
+ */
+int jscone_error_position(const char* json, size_t length, const JsconeError* error, size_t* line, size_t* column);
+
+/**
+ * @brief  calls log with every error as it happens, nothing is logged by default
+ * @note   not thread safe so set it before parsing, log is called from worker threads in jscone_parse_many() and jscone_parse_parallel()
+ * @param  log:  can be jscone_log_stderr, NULL to stop logging
+ */
+void jscone_set_log(JsconeLogFunc log, void* user);
+
+/**
+ * @brief  prints error to stderr, for jscone_set_log()
+ */
+void jscone_log_stderr(void* user, const JsconeError* error);
+
+
+/**
+ * internal types and functions
+ */
+
+#define JSCONE_TRUE 1
+#define JSCONE_FALSE 0 
+
+/* everything is allocated through the allocator set for this thread (see jscone_set_allocator()), the JSCONE_ALLOC macros by default */
+#define JSCONE_MEM_ALLOC(size) jscone_allocator->alloc(jscone_allocator->ctx, (size))
+#define JSCONE_MEM_STR_ALLOC(size) (jscone_allocator == &jscone_default_allocator ? JSCONE_STR_ALLOC(size) : JSCONE_MEM_ALLOC(size))
+#define JSCONE_MEM_REALLOC(ptr, size) jscone_allocator->realloc(jscone_allocator->ctx, (ptr), (size))
+#define JSCONE_MEM_FREE(ptr) do { if((ptr) != NULL) { jscone_allocator->free(jscone_allocator->ctx, (void*)(ptr)); } } while(0)
+
+/* for jscone_parse_document() */
+#define JSCONE_ARENA_MIN_BLOCK_SIZE 4096
+#define JSCONE_ARENA_ALIGN sizeof(double)
+#define JSCONE_ARENA_MAX_GUESS ((size_t)64 << 20) // first block guessed from the json's length, it doubles from there
+#define JSCONE_ARENA_GUESS(size) ((size) < JSCONE_ARENA_MAX_GUESS ? (size) : JSCONE_ARENA_MAX_GUESS)
+
+/* for jscone_parse_tape() */
+#define JSCONE_TAPE_OBJECT_START '{'
+#define JSCONE_TAPE_OBJECT_END   '}'
+#define JSCONE_TAPE_ARRAY_START  '['
+#define JSCONE_TAPE_ARRAY_END    ']'
+#define JSCONE_TAPE_KEY          'k'
+#define JSCONE_TAPE_STRING       '\"'
+#define JSCONE_TAPE_NUM          'd' // raw bits of the double are in the next entry
+#define JSCONE_TAPE_INT          'i' // int64_t in the next entry
+#define JSCONE_TAPE_TRUE         't'
+#define JSCONE_TAPE_FALSE        'f'
+#define JSCONE_TAPE_NULL         'n'
+#define JSCONE_TAPE_KEYED        0x80 // set in tag of values inside objects, the key is the entry before
+
+#define JSCONE_TAPE_PAYLOAD_MASK 0x00FFFFFFFFFFFFFFull
+#define JSCONE_TAPE_ENTRY(tag, payload) (((uint64_t)(tag) << 56) | ((uint64_t)(payload) & JSCONE_TAPE_PAYLOAD_MASK))
+#define JSCONE_TAPE_TAG(entry) ((unsigned char)((entry) >> 56))
+#define JSCONE_TAPE_PAYLOAD(entry) ((size_t)((entry) & JSCONE_TAPE_PAYLOAD_MASK))
+
+/* for the structural index, positions are kept on the stack while parsing */
+#define JSCONE_INDEX_CAPACITY 1024
+#define JSCONE_BLOCK_SIZE 64
+
+/* for jscone_parse_events() */
+#define JSCONE_EVENTS_BUFFER_SIZE 256
+
+/* for jscone_stream_new() */
+#define JSCONE_STREAM_MIN_DEPTH 16
+#define JSCONE_STREAM_MIN_TOKEN 256
+
+/* for jscone_parse_many() */
+#define JSCONE_MANY_BATCH_SIZE (1u << 20) // bytes of json per thread in each batch
+#define JSCONE_MANY_MAX_DOCS 16384        // documents in each batch
+#define JSCONE_MANY_MAX_THREADS 64
+
+/* for jscone_parse_parallel() */
+#define JSCONE_PARALLEL_RANGES 8 // per thread so uneven values still spread out
+
+/* for jscone_parser_parse_members() */
+#define JSCONE_PARSER_STACK_SIZE 32    // levels before the stack moves to the heap
+#define JSCONE_DEFAULT_MAX_DEPTH 1024 // of nesting, see JsconeOptions
+
+/* for jscone_write() */
+#define JSCONE_BUFFER_MIN_CAPACITY 256
+
+/* for jscone_symbols_new() */
+#define JSCONE_SYMBOLS_MIN_CAPACITY 64
+
+/* for jscone_get_member() */
+#define JSCONE_HASH_MIN_MEMBERS 16 // smaller objects are just searched through
+
+/* for jscone_print() */
+#define JSCONE_MAX_INDENT 20
+#define JSCONE_INDENT_SIZE 4
+
+/* for jscone_parser_parse_number() */
+#define JSCONE_MAX_MANTISSA_DIGITS 19 // always fits in uint64_t
+#define JSCONE_MAX_EXACT_INT (1ull << 53) // largest integer a double holds exactly (any below it too)
+#define JSCONE_MAX_EXACT_POW10 22 // largest power of 10 a double holds exactly
+#define JSCONE_NUM_BUFFER_SIZE 64
+#define JSCONE_STRTOD_DIGITS 800 // digits kept for longer numbers, more than the 767 it can take to decide how a double rounds
+#define JSCONE_STRTOD_BUFFER_SIZE (JSCONE_STRTOD_DIGITS + 16) // sign, digits, sticky digit and exponent
+#define JSCONE_IS_DIGIT(c) ((unsigned char)((c) - '0') < 10)
+#define JSCONE_IS_WHITESPACE(c) ((c) == ' ' || (c) == '\n' || (c) == '\r' || (c) == '\t')
+
+/* for jscone_parse_events(), does nothing if the callback is NULL */
+#define JSCONE_EVENT(events, callback, ...) ((events)->handler->callback == NULL || (events)->handler->callback(__VA_ARGS__) == JSCONE_SUCCESS \
+    ? JSCONE_SUCCESS : jscone_error_set(JSCONE_ERROR_CALLBACK, 0, "callback stopped parsing"))
+
+#define JSCONE_STREAM_ERROR(stream, code, message) jscone_error_set((code), (stream)->token_offset, (message))
+
+#define JSCONE_PARSER_NEXT_TOKEN(parser) if(jscone_lexer_next_token(&((parser)->lexer)) == JSCONE_FAILURE) { return JSCONE_FAILURE; }
+#define JSCONE_PARSER_TOKEN_LENGTH(parser) ((parser)->lexer.curr.end - (parser)->lexer.curr.first)
+#define JSCONE_LEXER_GET_FIRST_CHAR(lexer) ((lexer)->curr.first < (lexer)->length ? (lexer)->json[(lexer)->curr.first] : '\0') // \0 on EOF
+#define JSCONE_PARSER_GET_FIRST_CHAR(parser) JSCONE_LEXER_GET_FIRST_CHAR(&(parser)->lexer)
+#define JSCONE_PARSER_GET_LAST_CHAR(parser) ((parser)->lexer.json[(parser)->lexer.curr.end - 1])
+
+/* errors are only recorded (and logged if asked), position is the start of the current token */
+#define JSCONE_ERROR(code, message) jscone_error_set((code), 0, (message))
+#define JSCONE_LEXER_ERROR(lexer, code, message) jscone_error_set((code), (lexer)->base + (lexer)->curr.first, (message))
+#define JSCONE_PARSER_ERROR(parser, code, message) JSCONE_LEXER_ERROR(&(parser)->lexer, (code), (message))
+#define JSCONE_EXPECT_CHAR(parser, char, expected, message) \
+if(char != expected)                               \
+{                                                  \
+    JSCONE_PARSER_ERROR((parser), JSCONE_ERROR_SYNTAX, (message)); \
+    return JSCONE_FAILURE;                         \
+}
+#define JSCONE_EXPECT_FIRST_CHAR(parser, expected, message) JSCONE_EXPECT_CHAR((parser), JSCONE_PARSER_GET_FIRST_CHAR(parser), expected, message)
+#define JSCONE_EXPECT_LAST_CHAR(parser, expected, message) JSCONE_EXPECT_CHAR((parser), JSCONE_PARSER_GET_LAST_CHAR(parser), expected, message)
+
+typedef struct
+{
+    size_t first; // first character of token in json string (index)
+    size_t end;   // 1 past last character
+} JsconeToken;
+
+/* bitmasks of character classes in a 64 byte block, bit i is character i */
+typedef struct
+{
+    uint64_t quote;
+    uint64_t backslash;
+    uint64_t structural; // {}[]:,
+    uint64_t whitespace;
+    uint64_t control;    // below 0x20, not allowed in strings
+    uint64_t nul;
+    uint64_t high;       // 0x80 and above, for JSCONE_VALIDATE_UTF8
+} JsconeBlockMasks;
+
+typedef void (*JsconeClassifyFunc)(const char* block, JsconeBlockMasks* masks);
+
+/**
+ * positions of the start of every token, found 64 bytes at a time
+ * filled a window at a time by jscone_index_fill() as the lexer uses them up
+ */
+typedef struct
+{
+    size_t* positions;
+    size_t capacity;
+    size_t count;
+    size_t pos;     // next position for the lexer
+    size_t scanned; // bytes of json indexed so far
+
+    /* carried between blocks */
+    uint64_t prev_in_string; // all 1s if block ended inside a string
+    uint64_t prev_escaped;   // 1 if first char of next block is escaped
+    uint64_t prev_scalar;    // 1 if block ended on a number/true/false/null char
+    unsigned char utf8_remaining; // continuation bytes the last utf-8 character still needs
+    unsigned char utf8_min;       // range of the next one, narrower right after E0, ED, F0 and F4
+    unsigned char utf8_max;
+
+    unsigned char validate_utf8;
+    JsconeClassifyFunc classify;
+} JsconeIndex;
+
+typedef struct
+{
+    const char* json;
+    size_t length;
+    JsconeToken curr;
+    size_t base;           // offset of json in the whole input, only for error offsets
+    JsconeIndex* index;    // if not NULL tokens come from the index instead of scanning each byte
+} JsconeLexer;
+
+/* state for jscone_parse_events() */
+typedef struct
+{
+    const JsconeHandler* handler;
+    void* user;
+    char* buffer;    // strings are decoded here one at a time
+    size_t capacity;
+    size_t length;   // of the last decoded string
+} JsconeEvents;
+
+/* object/array being parsed */
+typedef struct
+{
+    JsconeType type;
+    const char* name; // values in arrays share the array's name
+} JsconeLevel;
+
+/* objects/arrays the parser is inside, starts in a buffer on the stack and moves to the heap if it gets deep */
+typedef struct
+{
+    JsconeLevel* levels;
+    size_t depth;
+    size_t capacity;
+    size_t max_depth;
+    JsconeLevel* local; // stack buffer, not freed
+} JsconeLevels;
+
+typedef struct
+{
+    JsconeLexer lexer;
+    JsconeNode* curr_node;
+    JsconeArena* arena; // if NULL nodes and strings are allocated individually with JSCONE_MEM_ALLOC
+    JsconeTape* tape;   // if not NULL values are pushed to the tape instead of creating nodes
+    JsconeEvents* events; // if not NULL values are given to handler callbacks instead of creating nodes
+    char* insitu;       // writable json, if not NULL strings are decoded in place
+    JsconeSymbolTable* symbols; // if not NULL names are interned into it
+    JsconeLevels* levels; // if not NULL a depth stack that moved to the heap is kept here for the next parse
+    unsigned int max_depth; // of nesting, 0 for JSCONE_DEFAULT_MAX_DEPTH
+    unsigned int flags; // JsconeOptions flags
+} JsconeParser;
+
+struct JsconeContext
+{
+    JsconeDocument doc;    // arena keeps its newest block between parses
+    JsconeLevels levels;   // only levels and capacity are used
+    JsconeOptions options;
+};
+
+int jscone_parser_parse_root(JsconeParser* parser);
+JsconeDocument* jscone_document_create(const char* json, size_t length, const JsconeOptions* options, char* insitu);
+char* jscone_file_open(const char* path, size_t* size);
+void jscone_file_close(char* json, size_t size, const JsconeAllocator* allocator);
+
+int jscone_parser_parse_value(JsconeParser* parser, const char* name);
+int jscone_parser_parse_object(JsconeParser* parser, const char* name);
+int jscone_parser_parse_array(JsconeParser* parser, const char* name);
+int jscone_parser_parse_members(JsconeParser* parser, JsconeType type, const char* name, char close); // close is \0 for EOF
+int jscone_parser_parse_levels(JsconeParser* parser, JsconeLevels* stack, char close);
+int jscone_levels_push(JsconeLevels* stack, JsconeType type, const char* name);
+int jscone_parser_parse_range(JsconeParser* parser, JsconeType type);
+int jscone_parser_parse_number(JsconeParser* parser, const char* name);
+/**
+ * @brief  reads a number token, JSCONE_INT if it is an integer a double can't hold exactly, otherwise JSCONE_NUM
+ */
+int jscone_number_parse(const char* str, size_t length, JsconeType* type, JsconeVal* value);
+double jscone_strtod(const char* str, size_t length);
+size_t jscone_number_shorten(char* buffer, const char* str, size_t length);
+int jscone_parser_parse_enum(JsconeParser* parser, const char* name);
+int jscone_parser_parse_string(JsconeParser* parser, const char* name);
+int jscone_parser_add_slice(JsconeParser* parser, const char* name);
+char* jscone_parser_parse_name(JsconeParser* parser);
+char* jscone_parser_get_string(JsconeParser* parser);
+char* jscone_parser_alloc_string(JsconeParser* parser, size_t size);
+void jscone_parser_end_string(JsconeParser* parser, char* string, size_t length);
+int jscone_parser_begin_node(JsconeParser* parser, JsconeType type, const char* name);
+int jscone_parser_end_node(JsconeParser* parser, JsconeType type);
+int jscone_parser_add_value(JsconeParser* parser, JsconeType type, JsconeVal value, const char* name);
+JsconeNode* jscone_parser_create_node(JsconeParser* parser, JsconeType type, JsconeVal value, const char* name);
+void jscone_parser_free(JsconeParser* parser, void* ptr);
+
+/**
+ * @note if first == end then EOF
+ */
+int jscone_lexer_next_token(JsconeLexer* lexer);
+int jscone_lexer_next_indexed_token(JsconeLexer* lexer);
+int jscone_lexer_lex_string(JsconeLexer* lexer);
+int jscone_error_set(JsconeErrorCode code, size_t offset, const char* message);
+
+void jscone_index_init(JsconeIndex* index, size_t* positions, size_t capacity);
+int jscone_index_fill(JsconeLexer* lexer);
+int jscone_index_block(JsconeIndex* index, const JsconeBlockMasks* masks, JsconeLexer* lexer);
+int jscone_index_utf8(JsconeIndex* index, const char* block, uint64_t high, JsconeLexer* lexer);
+void jscone_classify_scalar(const char* block, JsconeBlockMasks* masks);
+#ifdef JSCONE_SSE2
+void jscone_classify_sse2(const char* block, JsconeBlockMasks* masks);
+#endif
+#ifdef JSCONE_AVX2
+void jscone_classify_avx2(const char* block, JsconeBlockMasks* masks);
+#endif
+
+
+JsconeNode* jscone_find_name_in_siblings(JsconeParser* parser, const char* name);
+char* jscone_find_next_name(JsconeParser* parser, char* terminator);
+
+int jscone_buffer_reserve(JsconeBuffer* buf, size_t extra);
+int jscone_buffer_append(JsconeBuffer* buf, const char* data, size_t length);
+int jscone_write_newline(JsconeBuffer* buf, unsigned int indent, unsigned int depth);
+int jscone_write_string(JsconeBuffer* buf, const char* str, size_t length);
+int jscone_write_number(JsconeBuffer* buf, double num);
+int jscone_significant_digits(const char* str, size_t length);
+int jscone_write_integer(JsconeBuffer* buf, int64_t integer);
+size_t jscone_escape_scan(const char* str, size_t length);
+
+typedef struct
+{
+    JsconeNode* node; // NULL if empty
+    uint64_t hash;
+} JsconeMemberSlot;
+
+/* open addressing hash table of an object's children by name, first child with a name wins */
+typedef struct JsconeMembers
+{
+    size_t capacity; // power of 2
+    JsconeMemberSlot* slots; // follow the struct in the same allocation
+} JsconeMembers;
+
+typedef struct
+{
+    const char* name; // NULL if empty, its symbol is just before it
+    size_t length;
+    uint64_t hash;
+} JsconeSymbolSlot;
+
+struct JsconeSymbolTable
+{
+    JsconeArena arena; // names
+    JsconeSymbolSlot* slots;
+    size_t capacity;   // power of 2
+    size_t count;      // symbols are 1 to count
+};
+
+const char* jscone_symbols_intern(JsconeSymbolTable* symbols, const char* name, size_t length);
+int jscone_symbols_grow(JsconeSymbolTable* symbols);
+
+uint64_t jscone_hash(const char* key, size_t length);
+int jscone_members_build(JsconeNode* object, JsconeArena* arena);
+int jscone_elements_build(JsconeNode* arr, JsconeArena* arena);
+void jscone_elements_add(JsconeNode* arr, JsconeNode* node);
+JsconeNode* jscone_array_at(const JsconeNode* arr, size_t index);
+size_t jscone_path_index(const char* name);
+JsconeNode* jscone_members_find(const JsconeMembers* members, const char* key, size_t length, uint64_t hash);
+JsconeNode* jscone_path_find_sibling(JsconeNode* node, const JsconePathSegment* segment);
+unsigned char jscone_name_equals(const char* name, const char* key, size_t length);
+
+/* root of a tree that isn't in a document (JSCONE_NODE_TREE flag) */
+typedef struct
+{
+    JsconeNode node;
+    const JsconeAllocator* allocator; // the whole tree grows and is freed with this, whatever is set for the thread then
+} JsconeTree;
+
+JsconeNode* jscone_node_create(JsconeNode* parent, JsconeType type, JsconeVal value);
+JsconeNode* jscone_node_alloc(const JsconeNode* parent);
+const JsconeAllocator* jscone_node_allocator(const JsconeNode* node);
+void jscone_node_init(JsconeNode* node, JsconeNode* parent, JsconeType type, JsconeVal value);
+void jscone_node_free(JsconeNode* node);
+void jscone_node_print(JsconeNode* node, unsigned int indent);
+void jscone_node_print_value(const JsconeNode* node, unsigned int indent);
+
+int jscone_arena_init(JsconeArena* arena, size_t block_size);
+void* jscone_arena_alloc(JsconeArena* arena, size_t size, size_t align);
+void jscone_arena_free(JsconeArena* arena);
+void jscone_arena_reset(JsconeArena* arena);
+
+int jscone_tape_push(JsconeTape* tape, unsigned char tag, size_t payload);
+size_t jscone_tape_skip(const JsconeTape* tape, size_t index);
+
+int jscone_compact_build(JsconeCompact* compact, const JsconeTape* tape);
+void jscone_compact_set(JsconeCompactNode* node, const JsconeTape* tape, size_t tape_index);
+size_t jscone_compact_member(const JsconeCompact* compact, size_t index, const char* name);
+
+/* what jscone_stream_feed() expects next */
+typedef enum
+{
+    JSCONE_STREAM_ROOT,
+    JSCONE_STREAM_FIRST_VALUE, // after [, can be ]
+    JSCONE_STREAM_VALUE,
+    JSCONE_STREAM_FIRST_KEY,   // after {, can be }
+    JSCONE_STREAM_KEY,
+    JSCONE_STREAM_COLON,
+    JSCONE_STREAM_COMMA,       // after a value, can be } or ]
+    JSCONE_STREAM_END,         // after root, only whitespace
+} JsconeStreamState;
+
+
+struct JsconeStream
+{
+    JsconeParser parser; // lexer is pointed at each token once it is complete
+    JsconeEvents events;
+    JsconeNode* root;
+    char* key;           // name waiting for its value, owned until the value's node is made
+
+    JsconeStreamState state;
+    JsconeLevel* levels;
+    size_t depth;
+    size_t capacity;
+
+    /* token split over chunks is copied here */
+    char* token;
+    size_t token_length;
+    size_t token_capacity;
+    unsigned char in_string;
+    unsigned char in_atom;  // number/true/false/null
+    unsigned char escaped;
+    unsigned char failed;
+
+    size_t offset;       // bytes fed before the current chunk
+    size_t token_offset; // of the current token, for errors
+    const JsconeAllocator* allocator; // set when it was made, used for all of it whichever thread feeds it
+};
+
+int jscone_stream_parse(JsconeStream* stream, const char* chunk, size_t length);
+int jscone_stream_token(JsconeStream* stream, const char* token, size_t length);
+int jscone_stream_value(JsconeStream* stream, const char* token);
+int jscone_stream_begin(JsconeStream* stream, JsconeType type);
+int jscone_stream_end(JsconeStream* stream, char close);
+int jscone_stream_append(JsconeStream* stream, const char* chunk, size_t length);
+
+/* each thread parses a share of a batch of documents into its own arena */
+typedef struct
+{
+    struct JsconeMany* many;
+    JsconeArena arena; // reset every batch
+    size_t first;      // documents of the batch to parse
+    size_t end;
+    JsconeError error; // of the first document in the batch that failed
+#ifdef JSCONE_THREADS
+    pthread_t thread;
+#endif
+} JsconeWorker;
+
+typedef struct JsconeMany
+{
+    const char* json;
+    JsconeToken* docs;  // where each document in the batch is in json
+    JsconeNode** roots; // NULL if document failed
+    size_t count;
+    size_t capacity;
+    JsconeType range_type; // for jscone_parse_parallel(), if not JSCONE_NULL docs are ranges of values inside a root of this type
+    unsigned int flags;    // JsconeOptions flags
+    unsigned int max_depth;
+    const JsconeAllocator* allocator; // of the thread that started it, for the workers
+
+    JsconeWorker* workers;
+    unsigned int worker_count;
+#ifdef JSCONE_THREADS
+    pthread_mutex_t mutex;
+    pthread_cond_t start;
+    pthread_cond_t done;
+    unsigned int batch;   // incremented to start workers on the next batch
+    unsigned int pending; // workers that haven't finished the batch
+    unsigned char quit;
+    unsigned char started;
+#endif
+} JsconeMany;
+
+unsigned int jscone_many_threads(unsigned int threads);
+int jscone_many_start(JsconeMany* many, const char* json, size_t capacity, unsigned int threads);
+void jscone_many_stop(JsconeMany* many);
+int jscone_many_next(const char* json, size_t length, size_t* position, JsconeToken* doc);
+void jscone_many_run(JsconeMany* many);
+void jscone_many_error(const JsconeMany* many, size_t doc);
+size_t jscone_parallel_split(const char* json, size_t length, JsconeToken* ranges, size_t count, JsconeType* type);
+void jscone_worker_parse(JsconeWorker* worker);
+#ifdef JSCONE_THREADS
+void* jscone_worker_main(void* arg);
+#endif
+
+JsconeLexer jscone_cursor_lexer(const JsconeCursor* cursor);
+int jscone_cursor_read_element(JsconeCursor* cursor, JsconeLexer* lexer, unsigned char in_object);
+int jscone_cursor_skip(JsconeLexer* lexer);
+unsigned char jscone_cursor_name_equals(const JsconeCursor* cursor, const char* name, size_t length);
+
+
+#ifdef JSCONE_IMPLEMENTATION
+
+static const char* jscone_get_type_name(JsconeType type);
+
+static void* jscone_default_alloc(void* ctx, size_t size);
+static void* jscone_default_realloc(void* ctx, void* ptr, size_t size);
+static void jscone_default_free(void* ctx, void* ptr);
+
+static const JsconeAllocator jscone_default_allocator = {
+    .ctx = NULL,
+    .alloc = jscone_default_alloc,
+    .realloc = jscone_default_realloc,
+    .free = jscone_default_free,
+};
+static JSCONE_THREAD_LOCAL const JsconeAllocator* jscone_allocator = &jscone_default_allocator;
+static const JsconeAllocator* jscone_allocator_use(const JsconeAllocator* allocator);
+
+static JSCONE_THREAD_LOCAL JsconeError jscone_error = {.code = JSCONE_ERROR_NONE, .byte_offset = 0, .message = ""};
+static JsconeLogFunc jscone_log = NULL;
+static void* jscone_log_user = NULL;
+unsigned char jscone_parse_escape_sequence(JsconeParser* parser, size_t offset, char* bytes);
+int jscone_hex_codepoint(const char* hex, unsigned int* codepoint);
+unsigned char jscone_codepoint_to_utf8(char* bytes, unsigned int codepoint);
+
+/**
+ * exposed functions
+ */
+
+JsconeNode* jscone_parse(const char* json, size_t length)
+{
+    /* top object */
+    JsconeParser parser = {
+        .lexer = {
+            .json = json,
+            .length = length,
+            .curr = {.first = 0, .end = 0},
+        },
+        .curr_node = NULL,
+        .arena = NULL,
+    };
+
+    if(jscone_parser_parse_root(&parser) == JSCONE_FAILURE)
+    {
+        jscone_free(parser.curr_node);
+        return NULL;
+    }
+
+    return parser.curr_node;
+}
+
+JsconeNode* jscone_find(JsconeNode* node, const char* path)
+{
+    if(node == NULL || path == NULL)
+    {
+        return NULL;
+    }
+
+    JsconeParser parser = {
+        .lexer = {
+            .curr = {.first = 0, .end = 0},
+            .json = path,
+            .length = strlen(path),
+        },
+        .curr_node = node,
+    };
+    
+    /* skip current node and start search with children */
+    if(path[0] == '/')
+    {
+        if(node->child == NULL)
+        {
+            return NULL;
+        }
+
+        parser.curr_node = node->child;
+
+        /* skip past first / */
+        path++;
+        parser.lexer.json++;
+        parser.lexer.base = 1;
+    }
+
+    char* curr_name = NULL;
+    char terminator;
+    while(JSCONE_TRUE)
+    {
+        curr_name = jscone_find_next_name(&parser, &terminator);
+        if(curr_name == NULL)
+        {
+            return NULL;
+        }
+
+        if(jscone_find_name_in_siblings(&parser, curr_name) == NULL)
+        {
+            JSCONE_MEM_FREE(curr_name);
+            return NULL;
+        }
+        JSCONE_MEM_FREE(curr_name);
+
+        if(terminator == '\0')
+        {
+            return parser.curr_node;
+        }
+        else if(parser.curr_node->child == NULL)
+        {
+            JSCONE_PARSER_ERROR(&parser, JSCONE_ERROR_NOT_FOUND, "reached terminating node before it was expected");
+            return NULL;
+        }
+        parser.curr_node = parser.curr_node->child;
+    }
+
+    return NULL; // should not reach this
+}
+
+JsconeNode* jscone_get_member(JsconeNode* object, const char* key, size_t length)
+{
+    if(object == NULL || key == NULL || object->type != JSCONE_OBJECT)
+    {
+        return NULL;
+    }
+
+    if(object->flags & JSCONE_NODE_HASHED)
+    {
+        return jscone_members_find(object->value.members, key, length, jscone_hash(key, length));
+    }
+
+    size_t count = 0;
+    for(JsconeNode* child = object->child; child != NULL; child = child->next, count++)
+    {
+        /* big enough to be worth a table, documents can't own one made now */
+        if(count == JSCONE_HASH_MIN_MEMBERS && !(object->flags & JSCONE_NODE_ARENA))
+        {
+            const JsconeAllocator* allocator = jscone_allocator_use(jscone_node_allocator(object));
+            int built = jscone_members_build(object, NULL);
+            jscone_allocator_use(allocator);
+            if(built == JSCONE_SUCCESS)
+            {
+                return jscone_members_find(object->value.members, key, length, jscone_hash(key, length));
+            }
+        }
+
+        if(child->name != NULL && jscone_name_equals(child->name, key, length))
+        {
+            return child;
+        }
+    }
+
+    return NULL;
+}
+
+JsconeNode* jscone_array_get(JsconeNode* arr, size_t index)
+{
+    if(arr == NULL || arr->type != JSCONE_ARRAY || index >= arr->count)
+    {
+        return NULL;
+    }
+
+    /* vector was dropped when array was changed */
+    if(!(arr->flags & (JSCONE_NODE_INDEXED | JSCONE_NODE_ARENA)))
+    {
+        const JsconeAllocator* allocator = jscone_allocator_use(jscone_node_allocator(arr));
+        jscone_elements_build(arr, NULL);
+        jscone_allocator_use(allocator);
+    }
+
+    return jscone_array_at(arr, index);
+}
+
+size_t jscone_array_len(const JsconeNode* arr)
+{
+    return (arr != NULL && arr->type == JSCONE_ARRAY) ? arr->count : 0;
+}
+
+JsconePath* jscone_path_compile(const char* path)
+{
+    if(path == NULL)
+    {
+        return NULL;
+    }
+
+    JsconePath* compiled = (JsconePath*)JSCONE_MEM_ALLOC(sizeof(JsconePath));
+    if(compiled == NULL)
+    {
+        return NULL;
+    }
+
+    compiled->relative = path[0] != '/';
+    if(!compiled->relative)
+    {
+        path++;
+    }
+
+    /* one more name than unescaped slashes */
+    compiled->count = 1;
+    unsigned char escaped = JSCONE_FALSE;
+    for(const char* c = path; *c != '\0'; c++)
+    {
+        if(*c == '/' && !escaped)
+        {
+            compiled->count++;
+        }
+        escaped = *c == '\\' && !escaped;
+    }
+
+    compiled->segments = (JsconePathSegment*)JSCONE_MEM_ALLOC(compiled->count * sizeof(JsconePathSegment));
+    if(compiled->segments == NULL)
+    {
+        JSCONE_MEM_FREE(compiled);
+        return NULL;
+    }
+    memset(compiled->segments, 0, compiled->count * sizeof(JsconePathSegment));
+
+    JsconeParser parser = {
+        .lexer = {
+            .curr = {.first = 0, .end = 0},
+            .json = path,
+            .length = strlen(path),
+        },
+        .curr_node = NULL,
+    };
+
+    char terminator;
+    for(size_t i = 0; i < compiled->count; i++)
+    {
+        JsconePathSegment* segment = &compiled->segments[i];
+        segment->name = jscone_find_next_name(&parser, &terminator);
+        if(segment->name == NULL)
+        {
+            jscone_path_free(compiled);
+            return NULL;
+        }
+
+        segment->length = strlen(segment->name);
+        segment->hash = jscone_hash(segment->name, segment->length);
+        segment->index = jscone_path_index(segment->name);
+    }
+
+    return compiled;
+}
+
+JsconeNode* jscone_path_eval(JsconeNode* node, const JsconePath* path)
+{
+    if(node == NULL || path == NULL)
+    {
+        return NULL;
+    }
+
+    JsconeNode* found = path->relative ? node : node->child;
+    for(size_t i = 0; i < path->count && found != NULL; i++)
+    {
+        found = jscone_path_find_sibling(i == 0 ? found : found->child, &path->segments[i]);
+    }
+
+    return found;
+}
+
+int jscone_path_intern(JsconePath* path, JsconeSymbolTable* symbols)
+{
+    for(size_t i = 0; i < path->count; i++)
+    {
+        JsconePathSegment* segment = &path->segments[i];
+        const char* name = jscone_symbols_intern(symbols, segment->name, segment->length);
+        if(name == NULL)
+        {
+            return JSCONE_FAILURE;
+        }
+
+        memcpy(&segment->symbol, name - sizeof(unsigned int), sizeof(unsigned int));
+    }
+
+    return JSCONE_SUCCESS;
+}
+
+void jscone_path_free(JsconePath* path)
+{
+    if(path == NULL)
+    {
+        return;
+    }
+
+    for(size_t i = 0; i < path->count; i++)
+    {
+        JSCONE_MEM_FREE(path->segments[i].name);
+    }
+    JSCONE_MEM_FREE(path->segments);
+    JSCONE_MEM_FREE(path);
+}
+
+JsconeSymbolTable* jscone_symbols_new(void)
+{
+    JsconeSymbolTable* symbols = (JsconeSymbolTable*)JSCONE_MEM_ALLOC(sizeof(JsconeSymbolTable));
+    if(symbols == NULL)
+    {
+        return NULL;
+    }
+
+    symbols->capacity = JSCONE_SYMBOLS_MIN_CAPACITY;
+    symbols->count = 0;
+    symbols->slots = (JsconeSymbolSlot*)JSCONE_MEM_ALLOC(symbols->capacity * sizeof(JsconeSymbolSlot));
+    if(symbols->slots == NULL || jscone_arena_init(&symbols->arena, JSCONE_ARENA_MIN_BLOCK_SIZE) == JSCONE_FAILURE)
+    {
+        JSCONE_MEM_FREE(symbols->slots);
+        JSCONE_MEM_FREE(symbols);
+        return NULL;
+    }
+    memset(symbols->slots, 0, symbols->capacity * sizeof(JsconeSymbolSlot));
+
+    return symbols;
+}
+
+unsigned int jscone_symbols_find(const JsconeSymbolTable* symbols, const char* name, size_t length)
+{
+    uint64_t hash = jscone_hash(name, length);
+    size_t mask = symbols->capacity - 1;
+    for(size_t i = (size_t)hash & mask; symbols->slots[i].name != NULL; i = (i + 1) & mask)
+    {
+        const JsconeSymbolSlot* slot = &symbols->slots[i];
+        if(slot->hash == hash && slot->length == length && memcmp(slot->name, name, length) == 0)
+        {
+            unsigned int symbol;
+            memcpy(&symbol, slot->name - sizeof(unsigned int), sizeof(unsigned int));
+            return symbol;
+        }
+    }
+
+    return 0;
+}
+
+void jscone_symbols_free(JsconeSymbolTable* symbols)
+{
+    if(symbols == NULL)
+    {
+        return;
+    }
+
+    jscone_arena_free(&symbols->arena);
+    JSCONE_MEM_FREE(symbols->slots);
+    JSCONE_MEM_FREE(symbols);
+}
+
+unsigned int jscone_node_symbol(const JsconeNode* node)
+{
+    if(node == NULL || !(node->flags & JSCONE_NODE_INTERNED))
+    {
+        return 0;
+    }
+
+    unsigned int symbol;
+    memcpy(&symbol, node->name - sizeof(unsigned int), sizeof(unsigned int));
+    return symbol;
+}
+
+void jscone_free(JsconeNode* node)
+{
+    if(node == NULL)
+    {
+        return;
+    }
+    
+    /* find top node */
+    JsconeNode* head = node;
+    while(head->parent != NULL)
+    {
+        head = head->parent;
+    }
+
+    const JsconeAllocator* allocator = jscone_allocator_use(jscone_node_allocator(head));
+    jscone_node_free(head);
+    jscone_allocator_use(allocator);
+}
+
+JsconeDocument* jscone_parse_document(const char* json, size_t length, const JsconeOptions* options)
+{
+    return jscone_document_create(json, length, options, NULL);
+}
+
+JsconeDocument* jscone_parse_insitu(char* json, size_t length)
+{
+    /* only nodes go in the arena */
+    JsconeOptions options = {.block_size = JSCONE_ARENA_GUESS(length)};
+    return jscone_document_create(json, length, &options, json);
+}
+
+JsconeDocument* jscone_parse_file(const char* path, const JsconeOptions* options)
+{
+    size_t size;
+    char* json = jscone_file_open(path, &size);
+    if(json == NULL)
+    {
+        return NULL;
+    }
+
+    JsconeDocument* doc = jscone_document_create(json, size, options, NULL);
+    if(doc == NULL)
+    {
+        jscone_file_close(json, size, jscone_allocator);
+        return NULL;
+    }
+
+    doc->file = json;
+    doc->file_size = size;
+    return doc;
+}
+
+const char* jscone_document_string(JsconeDocument* doc, JsconeNode* node, size_t* length)
+{
+    if(node == NULL || node->type != JSCONE_STRING)
+    {
+        return NULL;
+    }
+
+    if(!(node->flags & JSCONE_NODE_RAW))
+    {
+        if(length != NULL)
+        {
+            *length = strlen(node->value.str);
+        }
+        return node->value.str;
+    }
+
+    JsconeSlice* slice = node->value.slice;
+    if(node->flags & JSCONE_NODE_ESCAPED)
+    {
+        /* decode string from between the quotes into the document */
+        JsconeParser parser = {
+            .lexer = {
+                .json = slice->str,
+                .length = slice->length + 1,
+                .curr = {.first = 0, .end = slice->length + 1},
+            },
+            .curr_node = NULL,
+            .arena = &doc->arena,
+        };
+
+        char* string = jscone_parser_get_string(&parser);
+        if(string == NULL)
+        {
+            return NULL;
+        }
+
+        /* cache it, from now on it's a normal string (written escaped again, not copied like a slice) */
+        node->value.str = string;
+        node->flags &= ~(unsigned int)(JSCONE_NODE_RAW | JSCONE_NODE_ESCAPED);
+        if(length != NULL)
+        {
+            *length = strlen(string);
+        }
+        return string;
+    }
+
+    if(length != NULL)
+    {
+        *length = slice->length;
+    }
+    return slice->str;
+}
+
+void jscone_document_free(JsconeDocument* doc)
+{
+    if(doc == NULL)
+    {
+        return;
+    }
+
+    /* copy out since doc is inside one of the blocks */
+    JsconeArena arena = doc->arena;
+    char* file = doc->file;
+    size_t file_size = doc->file_size;
+    jscone_arena_free(&arena);
+
+    if(file != NULL)
+    {
+        jscone_file_close(file, file_size, arena.allocator);
+    }
+}
+
+JsconeContext* jscone_context_new(const JsconeOptions* options)
+{
+    JsconeContext* context = (JsconeContext*)JSCONE_MEM_ALLOC(sizeof(JsconeContext));
+    if(context == NULL)
+    {
+        JSCONE_ERROR(JSCONE_ERROR_MEMORY, "could not allocate context");
+        return NULL;
+    }
+    memset(context, 0, sizeof(JsconeContext));
+    if(options != NULL)
+    {
+        context->options = *options;
+    }
+
+    /* first block is made by the first parse, once there is a length to guess its size from */
+    context->doc.arena.allocator = jscone_allocator;
+    return context;
+}
+
+JsconeDocument* jscone_context_parse(JsconeContext* context, const char* json, size_t length)
+{
+    JsconeDocument* doc = &context->doc;
+    doc->root = NULL;
+
+    /* depth stack is allocated the same way as the arena */
+    const JsconeAllocator* allocator = jscone_allocator;
+    jscone_allocator = doc->arena.allocator;
+
+    if(doc->arena.head == NULL)
+    {
+        size_t block_size = context->options.block_size != 0 ? context->options.block_size : JSCONE_ARENA_GUESS(length * 2);
+        if(jscone_arena_init(&doc->arena, block_size) == JSCONE_FAILURE)
+        {
+            jscone_allocator = allocator;
+            JSCONE_ERROR(JSCONE_ERROR_MEMORY, "could not allocate document");
+            return NULL;
+        }
+    }
+    else
+    {
+        /* O(1) once documents fit in the newest block */
+        jscone_arena_reset(&doc->arena);
+    }
+
+    JsconeParser parser = {
+        .lexer = {
+            .json = json,
+            .length = length,
+            .curr = {.first = 0, .end = 0},
+        },
+        .curr_node = NULL,
+        .arena = &doc->arena,
+        .levels = &context->levels,
+        .flags = context->options.flags,
+        .symbols = context->options.symbols,
+        .max_depth = context->options.max_depth,
+    };
+
+    int ret = jscone_parser_parse_root(&parser);
+    jscone_allocator = allocator;
+    if(ret == JSCONE_FAILURE)
+    {
+        return NULL;
+    }
+
+    doc->root = parser.curr_node;
+    return doc;
+}
+
+void jscone_context_free(JsconeContext* context)
+{
+    if(context == NULL)
+    {
+        return;
+    }
+
+    const JsconeAllocator* allocator = context->doc.arena.allocator;
+    jscone_arena_free(&context->doc.arena);
+    if(context->levels.levels != NULL)
+    {
+        allocator->free(allocator->ctx, context->levels.levels);
+    }
+    allocator->free(allocator->ctx, context);
+}
+
+JsconeTape* jscone_parse_tape(const char* json, size_t length)
+{
+    JsconeTape* tape = (JsconeTape*)JSCONE_MEM_ALLOC(sizeof(JsconeTape));
+    if(tape == NULL)
+    {
+        return NULL;
+    }
+
+    /* start with a guess, both grow as needed */
+    tape->capacity = length / 8 + 16;
+    tape->length = 0;
+    tape->entries = (uint64_t*)JSCONE_MEM_ALLOC(tape->capacity * sizeof(uint64_t));
+    tape->strings_capacity = length / 2 + 16;
+    tape->strings_length = 0;
+    tape->strings = (char*)JSCONE_MEM_STR_ALLOC(tape->strings_capacity * sizeof(char));
+    tape->allocator = jscone_allocator;
+    tape->open = 0;
+    tape->keyed = JSCONE_FALSE;
+
+    if(tape->entries == NULL || tape->strings == NULL)
+    {
+        jscone_tape_free(tape);
+        return NULL;
+    }
+
+    JsconeParser parser = {
+        .lexer = {
+            .json = json,
+            .length = length,
+            .curr = {.first = 0, .end = 0},
+        },
+        .curr_node = NULL,
+        .arena = NULL,
+        .tape = tape,
+    };
+
+    if(jscone_parser_parse_root(&parser) == JSCONE_FAILURE)
+    {
+        jscone_tape_free(tape);
+        return NULL;
+    }
+
+    return tape;
+}
+
+int jscone_parse_events(const char* json, size_t length, const JsconeHandler* handler, void* user)
+{
+    JsconeEvents events = {
+        .handler = handler,
+        .user = user,
+        .buffer = (char*)JSCONE_MEM_STR_ALLOC(JSCONE_EVENTS_BUFFER_SIZE),
+        .capacity = JSCONE_EVENTS_BUFFER_SIZE,
+        .length = 0,
+    };
+    if(events.buffer == NULL)
+    {
+        return JSCONE_FAILURE;
+    }
+
+    JsconeParser parser = {
+        .lexer = {
+            .json = json,
+            .length = length,
+            .curr = {.first = 0, .end = 0},
+        },
+        .curr_node = NULL,
+        .arena = NULL,
+        .events = &events,
+    };
+
+    int ret = jscone_parser_parse_root(&parser);
+    JSCONE_MEM_FREE(events.buffer);
+    return ret;
+}
+
+int jscone_parse_many(const char* json, size_t length, unsigned int threads, JsconeManyFunc callback, void* user)
+{
+    JsconeMany many;
+    if(jscone_many_start(&many, json, JSCONE_MANY_MAX_DOCS, threads) == JSCONE_FAILURE)
+    {
+        return JSCONE_FAILURE;
+    }
+
+    int ret = JSCONE_FAILURE;
+    size_t position = 0;
+    JsconeToken doc;
+    unsigned char more = JSCONE_TRUE;
+    while(more)
+    {
+        /* find next batch of documents */
+        size_t batch_size = (size_t)JSCONE_MANY_BATCH_SIZE * many.worker_count;
+        size_t bytes = 0;
+        many.count = 0;
+        while(many.count < JSCONE_MANY_MAX_DOCS && bytes < batch_size)
+        {
+            if(jscone_many_next(json, length, &position, &doc) == JSCONE_FAILURE)
+            {
+                more = JSCONE_FALSE;
+                break;
+            }
+            many.docs[many.count++] = doc;
+            bytes += doc.end - doc.first;
+        }
+
+        jscone_many_run(&many);
+
+        /* give documents in order */
+        for(size_t i = 0; i < many.count; i++)
+        {
+            if(many.roots[i] == NULL)
+            {
+                jscone_many_error(&many, i);
+                goto end;
+            }
+            if(callback(user, many.roots[i]) == JSCONE_FAILURE)
+            {
+                JSCONE_ERROR(JSCONE_ERROR_CALLBACK, "callback stopped parsing");
+                goto end;
+            }
+        }
+    }
+    ret = JSCONE_SUCCESS;
+
+    end:
+    jscone_many_stop(&many);
+    return ret;
+}
+
+JsconeDocument* jscone_parse_parallel(const char* json, size_t length, const JsconeOptions* options, unsigned int threads)
+{
+    /* cpu count has to be known before the ranges are */
+    threads = jscone_many_threads(threads);
+    JsconeMany many;
+    if(jscone_many_start(&many, json, (size_t)threads * JSCONE_PARALLEL_RANGES, threads) == JSCONE_FAILURE)
+    {
+        return NULL;
+    }
+    many.flags = options != NULL ? options->flags : 0;
+    many.max_depth = options != NULL ? options->max_depth : 0;
+
+    /* nodes go in the workers' arenas, this only holds the document and root */
+    JsconeArena arena;
+    if(jscone_arena_init(&arena, JSCONE_ARENA_MIN_BLOCK_SIZE) == JSCONE_FAILURE)
+    {
+        JSCONE_ERROR(JSCONE_ERROR_MEMORY, "could not allocate document");
+        jscone_many_stop(&many);
+        return NULL;
+    }
+
+    JsconeDocument* doc = (JsconeDocument*)jscone_arena_alloc(&arena, sizeof(JsconeDocument), JSCONE_ARENA_ALIGN);
+    if(doc == NULL)
+    {
+        jscone_arena_free(&arena);
+        jscone_many_stop(&many);
+        return NULL;
+    }
+    doc->root = NULL;
+    doc->arena = arena;
+    doc->file = NULL;
+    doc->file_size = 0;
+
+    /* values inside root are split into ranges that are parsed separately */
+    JsconeType type;
+    many.count = jscone_parallel_split(json, length, many.docs, many.capacity, &type);
+    if(many.count == 0)
+    {
+        goto fail;
+    }
+    many.range_type = type;
+    jscone_many_run(&many);
+
+    JsconeParser parser = {.arena = &doc->arena};
+    JsconeNode* root = jscone_parser_create_node(&parser, type, (JsconeVal){0}, NULL);
+    if(root == NULL)
+    {
+        goto fail;
+    }
+
+    /* move values from each range under the real root */
+    JsconeNode* last = NULL;
+    for(size_t i = 0; i < many.count; i++)
+    {
+        if(many.roots[i] == NULL)
+        {
+            jscone_many_error(&many, i);
+            goto fail;
+        }
+
+        JsconeNode* child = many.roots[i]->child;
+        if(child == NULL)
+        {
+            continue;
+        }
+
+        if(last == NULL)
+        {
+            root->child = child;
+        }
+        else
+        {
+            last->next = child;
+            child->prev = last;
+        }
+
+        for(; child != NULL; child = child->next)
+        {
+            child->parent = root;
+            last = child;
+        }
+        root->count += many.roots[i]->count;
+    }
+    root->last = last;
+    doc->root = root;
+
+    if(type == JSCONE_OBJECT && (many.flags & JSCONE_HASH_MEMBERS) && root->count >= JSCONE_HASH_MIN_MEMBERS
+    && jscone_members_build(root, &doc->arena) == JSCONE_FAILURE)
+    {
+        goto fail;
+    }
+    if(type == JSCONE_ARRAY && jscone_elements_build(root, &doc->arena) == JSCONE_FAILURE)
+    {
+        goto fail;
+    }
+
+    /* document takes the workers' blocks */
+    JsconeArenaBlock* tail = doc->arena.head;
+    while(tail->next != NULL)
+    {
+        tail = tail->next;
+    }
+    for(unsigned int i = 0; i < many.worker_count; i++)
+    {
+        tail->next = many.workers[i].arena.head;
+        while(tail->next != NULL)
+        {
+            tail = tail->next;
+        }
+        many.workers[i].arena.head = NULL;
+    }
+
+    jscone_many_stop(&many);
+    return doc;
+
+    fail:
+    jscone_many_stop(&many);
+    jscone_document_free(doc);
+    return NULL;
+}
+
+JsconeStream* jscone_stream_new(const JsconeHandler* handler, void* user)
+{
+    JsconeStream* stream = (JsconeStream*)JSCONE_MEM_ALLOC(sizeof(JsconeStream));
+    if(stream == NULL)
+    {
+        return NULL;
+    }
+    memset(stream, 0, sizeof(JsconeStream));
+
+    stream->allocator = jscone_allocator;
+    stream->state = JSCONE_STREAM_ROOT;
+    stream->capacity = JSCONE_STREAM_MIN_DEPTH;
+    stream->levels = (JsconeLevel*)JSCONE_MEM_ALLOC(stream->capacity * sizeof(JsconeLevel));
+    stream->token_capacity = JSCONE_STREAM_MIN_TOKEN;
+    stream->token = (char*)JSCONE_MEM_STR_ALLOC(stream->token_capacity);
+
+    if(handler != NULL)
+    {
+        stream->events = (JsconeEvents){
+            .handler = handler,
+            .user = user,
+            .buffer = (char*)JSCONE_MEM_STR_ALLOC(JSCONE_EVENTS_BUFFER_SIZE),
+            .capacity = JSCONE_EVENTS_BUFFER_SIZE,
+            .length = 0,
+        };
+        stream->parser.events = &stream->events;
+    }
+
+    if(stream->levels == NULL || stream->token == NULL || (handler != NULL && stream->events.buffer == NULL))
+    {
+        JSCONE_MEM_FREE(stream->levels);
+        JSCONE_MEM_FREE(stream->token);
+        JSCONE_MEM_FREE(stream->events.buffer);
+        JSCONE_MEM_FREE(stream);
+        return NULL;
+    }
+
+    return stream;
+}
+
+int jscone_stream_feed(JsconeStream* stream, const char* chunk, size_t length)
+{
+    const JsconeAllocator* allocator = jscone_allocator_use(stream->allocator);
+    int ret = jscone_stream_parse(stream, chunk, length);
+    jscone_allocator_use(allocator);
+    return ret;
+}
+
+int jscone_stream_parse(JsconeStream* stream, const char* chunk, size_t length)
+{
+    if(stream->failed)
+    {
+        return JSCONE_FAILURE;
+    }
+
+    size_t i = 0;
+    size_t start = 0; // of the current token in this chunk
+    char c;
+    while(i < length)
+    {
+        if(stream->in_string)
+        {
+            for(; i < length; i++)
+            {
+                c = chunk[i];
+                if(stream->escaped)
+                {
+                    stream->escaped = JSCONE_FALSE;
+                }
+                else if(c == '\\')
+                {
+                    stream->escaped = JSCONE_TRUE;
+                }
+                else if(c == '\"')
+                {
+                    break;
+                }
+                else if((unsigned char)c < 0x20)
+                {
+                    JSCONE_STREAM_ERROR(stream, JSCONE_ERROR_STRING, "invalid control character in string (newline, tab)");
+                    goto fail;
+                }
+            }
+
+            if(i == length)
+            {
+                break; // rest of string is in the next chunk
+            }
+
+            i++; // include last "
+            stream->in_string = JSCONE_FALSE;
+        }
+        else if(stream->in_atom)
+        {
+            for(; i < length; i++)
+            {
+                c = chunk[i];
+                if(c == ' ' || c == '\t' || c == '\r' || c == '\n' || c == ',' || c == ':'
+                   || c == '{' || c == '}' || c == '[' || c == ']')
+                {
+                    break;
+                }
+                if(c == '\"')
+                {
+                    JSCONE_STREAM_ERROR(stream, JSCONE_ERROR_SYNTAX, "unexpected char \"");
+                    goto fail;
+                }
+            }
+
+            if(i == length)
+            {
+                break;
+            }
+
+            stream->in_atom = JSCONE_FALSE;
+        }
+        else
+        {
+            /* between tokens */
+            c = chunk[i];
+            switch(c)
+            {
+                case ' ': case '\t': case '\r': case '\n':
+                    i++;
+                    continue;
+                case '{': case '}':
+                case '[': case ']':
+                case ':': case ',':
+                    stream->token_offset = stream->offset + i;
+                    if(jscone_stream_token(stream, chunk + i, 1) == JSCONE_FAILURE)
+                    {
+                        goto fail;
+                    }
+                    i++;
+                    continue;
+                case '\"':
+                    stream->in_string = JSCONE_TRUE;
+                    stream->token_offset = stream->offset + i;
+                    start = i++;
+                    continue;
+                default:
+                    stream->in_atom = JSCONE_TRUE;
+                    stream->token_offset = stream->offset + i;
+                    start = i++;
+                    continue;
+            }
+        }
+
+        /* token has ended, only copy it if it started in an earlier chunk */
+        int ret;
+        if(stream->token_length == 0)
+        {
+            ret = jscone_stream_token(stream, chunk + start, i - start);
+        }
+        else
+        {
+            ret = jscone_stream_append(stream, chunk + start, i - start);
+            if(ret == JSCONE_SUCCESS)
+            {
+                ret = jscone_stream_token(stream, stream->token, stream->token_length);
+            }
+            stream->token_length = 0;
+        }
+
+        if(ret == JSCONE_FAILURE)
+        {
+            goto fail;
+        }
+        start = i;
+    }
+
+    /* keep unfinished token for next chunk */
+    if((stream->in_string || stream->in_atom) && jscone_stream_append(stream, chunk + start, length - start) == JSCONE_FAILURE)
+    {
+        goto fail;
+    }
+
+    stream->offset += length;
+    return JSCONE_SUCCESS;
+
+    fail:
+    stream->failed = JSCONE_TRUE;
+    return JSCONE_FAILURE;
+}
+
+int jscone_stream_finish(JsconeStream* stream, JsconeNode** root)
+{
+    const JsconeAllocator* allocator = jscone_allocator_use(stream->allocator);
+    if(!stream->failed && stream->in_atom) // number/true/false/null at end of json
+    {
+        stream->in_atom = JSCONE_FALSE;
+        stream->failed = jscone_stream_token(stream, stream->token, stream->token_length) == JSCONE_FAILURE;
+    }
+
+    if(!stream->failed && stream->in_string)
+    {
+        JSCONE_STREAM_ERROR(stream, JSCONE_ERROR_STRING, "expected char \" before end of file");
+        stream->failed = JSCONE_TRUE;
+    }
+    else if(!stream->failed && stream->state != JSCONE_STREAM_END)
+    {
+        stream->token_offset = stream->offset;
+        JSCONE_STREAM_ERROR(stream, JSCONE_ERROR_SYNTAX, "json ended early");
+        stream->failed = JSCONE_TRUE;
+    }
+
+    int ret = stream->failed ? JSCONE_FAILURE : JSCONE_SUCCESS;
+    if(stream->failed)
+    {
+        jscone_parser_free(&stream->parser, stream->key);
+        jscone_free(stream->root);
+    }
+    else if(root != NULL)
+    {
+        *root = stream->root;
+    }
+
+    JSCONE_MEM_FREE(stream->levels);
+    JSCONE_MEM_FREE(stream->token);
+    JSCONE_MEM_FREE(stream->events.buffer);
+    JSCONE_MEM_FREE(stream);
+    jscone_allocator_use(allocator);
+    return ret;
+}
+
+void jscone_tape_free(JsconeTape* tape)
+{
+    if(tape == NULL)
+    {
+        return;
+    }
+
+    const JsconeAllocator* allocator = jscone_allocator_use(tape->allocator);
+    JSCONE_MEM_FREE(tape->entries);
+    JSCONE_MEM_FREE(tape->strings);
+    JSCONE_MEM_FREE(tape);
+    jscone_allocator_use(allocator);
+}
+
+JsconeType jscone_tape_type(const JsconeTape* tape, size_t index)
+{
+    switch(JSCONE_TAPE_TAG(tape->entries[index]) & ~JSCONE_TAPE_KEYED)
+    {
+        case JSCONE_TAPE_OBJECT_START:
+            return JSCONE_OBJECT;
+        case JSCONE_TAPE_ARRAY_START:
+            return JSCONE_ARRAY;
+        case JSCONE_TAPE_STRING:
+            return JSCONE_STRING;
+        case JSCONE_TAPE_NUM:
+            return JSCONE_NUM;
+        case JSCONE_TAPE_INT:
+            return JSCONE_INT;
+        case JSCONE_TAPE_TRUE: case JSCONE_TAPE_FALSE:
+            return JSCONE_BOOL;
+        default:
+            return JSCONE_NULL;
+    }
+}
+
+const char* jscone_tape_name(const JsconeTape* tape, size_t index)
+{
+    if(!(JSCONE_TAPE_TAG(tape->entries[index]) & JSCONE_TAPE_KEYED))
+    {
+        return NULL;
+    }
+
+    return jscone_tape_string(tape, index - 1, NULL);
+}
+
+const char* jscone_tape_string(const JsconeTape* tape, size_t index, size_t* length)
+{
+    const char* string = tape->strings + JSCONE_TAPE_PAYLOAD(tape->entries[index]);
+
+    if(length != NULL)
+    {
+        memcpy(length, string, sizeof(size_t));
+    }
+
+    return string + sizeof(size_t);
+}
+
+double jscone_tape_num(const JsconeTape* tape, size_t index)
+{
+    if((JSCONE_TAPE_TAG(tape->entries[index]) & ~JSCONE_TAPE_KEYED) == JSCONE_TAPE_INT)
+    {
+        return (double)jscone_tape_int(tape, index);
+    }
+
+    double num;
+    memcpy(&num, &tape->entries[index + 1], sizeof(double));
+    return num;
+}
+
+int64_t jscone_tape_int(const JsconeTape* tape, size_t index)
+{
+    if((JSCONE_TAPE_TAG(tape->entries[index]) & ~JSCONE_TAPE_KEYED) == JSCONE_TAPE_NUM)
+    {
+        return (int64_t)jscone_tape_num(tape, index);
+    }
+
+    int64_t integer;
+    memcpy(&integer, &tape->entries[index + 1], sizeof(int64_t));
+    return integer;
+}
+
+unsigned char jscone_tape_bool(const JsconeTape* tape, size_t index)
+{
+    return (JSCONE_TAPE_TAG(tape->entries[index]) & ~JSCONE_TAPE_KEYED) == JSCONE_TAPE_TRUE;
+}
+
+size_t jscone_tape_child(const JsconeTape* tape, size_t index)
+{
+    switch(JSCONE_TAPE_TAG(tape->entries[index]) & ~JSCONE_TAPE_KEYED)
+    {
+        case JSCONE_TAPE_OBJECT_START:
+            /* skip over key */
+            return (index + 1 == JSCONE_TAPE_PAYLOAD(tape->entries[index])) ? JSCONE_TAPE_NONE : index + 2;
+        case JSCONE_TAPE_ARRAY_START:
+            return (index + 1 == JSCONE_TAPE_PAYLOAD(tape->entries[index])) ? JSCONE_TAPE_NONE : index + 1;
+        default:
+            return JSCONE_TAPE_NONE;
+    }
+}
+
+size_t jscone_tape_next(const JsconeTape* tape, size_t index)
+{
+    size_t next = jscone_tape_skip(tape, index);
+    if(next >= tape->length)
+    {
+        return JSCONE_TAPE_NONE;
+    }
+
+    switch(JSCONE_TAPE_TAG(tape->entries[next]))
+    {
+        case JSCONE_TAPE_OBJECT_END: case JSCONE_TAPE_ARRAY_END:
+            return JSCONE_TAPE_NONE;
+        case JSCONE_TAPE_KEY:
+            return next + 1;
+        default:
+            return next;
+    }
+}
+
+size_t jscone_tape_find(const JsconeTape* tape, size_t index, const char* path)
+{
+    if(tape == NULL || path == NULL || index == JSCONE_TAPE_NONE)
+    {
+        return JSCONE_TAPE_NONE;
+    }
+
+    JsconeParser parser = {
+        .lexer = {
+            .curr = {.first = 0, .end = 0},
+            .json = path,
+            .length = strlen(path),
+        },
+        .curr_node = NULL,
+    };
+
+    /* skip current value and start search with children */
+    if(path[0] == '/')
+    {
+        index = jscone_tape_child(tape, index);
         parser.lexer.json++;
     }
 
-    char* curr_name = NULL;
+    char* curr_name = NULL;
+    char terminator;
+    while(index != JSCONE_TAPE_NONE)
+    {
+        curr_name = jscone_find_next_name(&parser, &terminator);
+        if(curr_name == NULL)
+        {
+            return JSCONE_TAPE_NONE;
+        }
+
+        /* search siblings */
+        const char* name;
+        while(index != JSCONE_TAPE_NONE)
+        {
+            name = jscone_tape_name(tape, index);
+            if(name != NULL && strcmp(name, curr_name) == 0)
+            {
+                break;
+            }
+            index = jscone_tape_next(tape, index);
+        }
+        JSCONE_MEM_FREE(curr_name);
+
+        if(terminator == '\0' || index == JSCONE_TAPE_NONE)
+        {
+            return index;
+        }
+        index = jscone_tape_child(tape, index);
+    }
+
+    return JSCONE_TAPE_NONE;
+}
+
+JsconeCompact* jscone_parse_compact(const char* json, size_t length)
+{
+    JsconeTape* tape = jscone_parse_tape(json, length);
+    if(tape == NULL)
+    {
+        return NULL;
+    }
+
+    JsconeCompact* compact = (JsconeCompact*)JSCONE_MEM_ALLOC(sizeof(JsconeCompact));
+    if(compact == NULL)
+    {
+        JSCONE_ERROR(JSCONE_ERROR_MEMORY, "could not allocate compact nodes");
+        jscone_tape_free(tape);
+        return NULL;
+    }
+
+    /* strings are taken from the tape as they are */
+    compact->nodes = NULL;
+    compact->count = 0;
+    compact->strings = tape->strings;
+    compact->strings_length = tape->strings_length;
+    compact->allocator = tape->allocator;
+    tape->strings = NULL;
+
+    int ret = jscone_compact_build(compact, tape);
+    jscone_tape_free(tape);
+    if(ret == JSCONE_FAILURE)
+    {
+        jscone_compact_free(compact);
+        return NULL;
+    }
+
+    return compact;
+}
+
+void jscone_compact_free(JsconeCompact* compact)
+{
+    if(compact == NULL)
+    {
+        return;
+    }
+
+    const JsconeAllocator* allocator = jscone_allocator_use(compact->allocator);
+    JSCONE_MEM_FREE(compact->nodes);
+    JSCONE_MEM_FREE(compact->strings);
+    JSCONE_MEM_FREE(compact);
+    jscone_allocator_use(allocator);
+}
+
+JsconeType jscone_compact_type(const JsconeCompact* compact, size_t index)
+{
+    return (JsconeType)compact->nodes[index].type;
+}
+
+const char* jscone_compact_name(const JsconeCompact* compact, size_t index)
+{
+    if(compact->nodes[index].name == JSCONE_COMPACT_NO_NAME)
+    {
+        return NULL;
+    }
+
+    return compact->strings + compact->nodes[index].name + sizeof(size_t);
+}
+
+const char* jscone_compact_string(const JsconeCompact* compact, size_t index, size_t* length)
+{
+    const char* string = compact->strings + compact->nodes[index].value;
+
+    if(length != NULL)
+    {
+        memcpy(length, string, sizeof(size_t));
+    }
+
+    return string + sizeof(size_t);
+}
+
+double jscone_compact_num(const JsconeCompact* compact, size_t index)
+{
+    if(compact->nodes[index].type == JSCONE_INT)
+    {
+        return (double)jscone_compact_int(compact, index);
+    }
+
+    double num;
+    memcpy(&num, &compact->nodes[index].value, sizeof(double));
+    return num;
+}
+
+int64_t jscone_compact_int(const JsconeCompact* compact, size_t index)
+{
+    if(compact->nodes[index].type == JSCONE_NUM)
+    {
+        return (int64_t)jscone_compact_num(compact, index);
+    }
+
+    int64_t integer;
+    memcpy(&integer, &compact->nodes[index].value, sizeof(int64_t));
+    return integer;
+}
+
+unsigned char jscone_compact_bool(const JsconeCompact* compact, size_t index)
+{
+    return compact->nodes[index].type == JSCONE_BOOL && compact->nodes[index].value != 0;
+}
+
+size_t jscone_compact_len(const JsconeCompact* compact, size_t index)
+{
+    const JsconeCompactNode* node = &compact->nodes[index];
+    if(node->type != JSCONE_OBJECT && node->type != JSCONE_ARRAY)
+    {
+        return 0;
+    }
+
+    return (size_t)(node->value >> 32);
+}
+
+size_t jscone_compact_child(const JsconeCompact* compact, size_t index, size_t n)
+{
+    if(n >= jscone_compact_len(compact, index))
+    {
+        return JSCONE_COMPACT_NONE;
+    }
+
+    return (size_t)(compact->nodes[index].value & 0xFFFFFFFFu) + n;
+}
+
+size_t jscone_compact_find(const JsconeCompact* compact, size_t index, const char* path)
+{
+    if(compact == NULL || path == NULL || index == JSCONE_COMPACT_NONE)
+    {
+        return JSCONE_COMPACT_NONE;
+    }
+
+    const char* names = path[0] == '/' ? path + 1 : path;
+    JsconeParser parser = {
+        .lexer = {
+            .curr = {.first = 0, .end = 0},
+            .json = names,
+            .length = strlen(names),
+            .base = (size_t)(names - path),
+        },
+        .curr_node = NULL,
+    };
+
+    char* curr_name = NULL;
+    char terminator;
+    while(index != JSCONE_COMPACT_NONE)
+    {
+        curr_name = jscone_find_next_name(&parser, &terminator);
+        if(curr_name == NULL)
+        {
+            return JSCONE_COMPACT_NONE;
+        }
+
+        index = jscone_compact_member(compact, index, curr_name);
+        JSCONE_MEM_FREE(curr_name);
+
+        if(terminator == '\0')
+        {
+            return index;
+        }
+    }
+
+    return JSCONE_COMPACT_NONE;
+}
+
+int jscone_cursor_init(JsconeCursor* cursor, const char* json, size_t length)
+{
+    JsconeLexer lexer = {
+        .json = json,
+        .length = length,
+        .curr = {.first = 0, .end = 0},
+        .index = NULL,
+    };
+
+    if(jscone_lexer_next_token(&lexer) == JSCONE_FAILURE)
+    {
+        return JSCONE_FAILURE;
+    }
+
+    *cursor = (JsconeCursor){.json = json, .length = length};
+    return jscone_cursor_read_element(cursor, &lexer, JSCONE_FALSE);
+}
+
+JsconeType jscone_cursor_type(const JsconeCursor* cursor)
+{
+    switch(cursor->json[cursor->first])
+    {
+        case '{':
+            return JSCONE_OBJECT;
+        case '[':
+            return JSCONE_ARRAY;
+        case '\"':
+            return JSCONE_STRING;
+        case 't': case 'f':
+            return JSCONE_BOOL;
+        case 'n':
+            return JSCONE_NULL;
+        default:
+            return JSCONE_NUM;
+    }
+}
+
+int jscone_cursor_find_field(JsconeCursor* cursor, const char* name)
+{
+    if(cursor->json[cursor->first] != '{' || name == NULL)
+    {
+        return JSCONE_FAILURE;
+    }
+
+    JsconeCursor field = *cursor;
+    if(jscone_cursor_first_element(&field) == JSCONE_FAILURE)
+    {
+        return JSCONE_FAILURE;
+    }
+
+    size_t length = strlen(name);
+    do
+    {
+        if(jscone_cursor_name_equals(&field, name, length))
+        {
+            *cursor = field;
+            return JSCONE_SUCCESS;
+        }
+    } while(jscone_cursor_next_element(&field) == JSCONE_SUCCESS);
+
+    return JSCONE_FAILURE;
+}
+
+int jscone_cursor_find(JsconeCursor* cursor, const char* path)
+{
+    if(path == NULL)
+    {
+        return JSCONE_FAILURE;
+    }
+
+    path += path[0] == '/';
+    JsconeParser parser = {
+        .lexer = {
+            .curr = {.first = 0, .end = 0},
+            .json = path,
+            .length = strlen(path),
+        },
+        .curr_node = NULL,
+    };
+
+    JsconeCursor field = *cursor;
+    char* curr_name = NULL;
+    char terminator;
+    while(JSCONE_TRUE)
+    {
+        curr_name = jscone_find_next_name(&parser, &terminator);
+        if(curr_name == NULL)
+        {
+            return JSCONE_FAILURE;
+        }
+
+        int ret = jscone_cursor_find_field(&field, curr_name);
+        JSCONE_MEM_FREE(curr_name);
+
+        if(ret == JSCONE_FAILURE)
+        {
+            return JSCONE_FAILURE;
+        }
+        if(terminator == '\0')
+        {
+            *cursor = field;
+            return JSCONE_SUCCESS;
+        }
+    }
+}
+
+int jscone_cursor_first_element(JsconeCursor* cursor)
+{
+    char open = cursor->json[cursor->first];
+    if(open != '{' && open != '[')
+    {
+        return JSCONE_FAILURE;
+    }
+
+    JsconeLexer lexer = jscone_cursor_lexer(cursor);
+    if(jscone_lexer_next_token(&lexer) == JSCONE_FAILURE)
+    {
+        return JSCONE_FAILURE;
+    }
+
+    /* empty */
+    if(JSCONE_LEXER_GET_FIRST_CHAR(&lexer) == (open == '{' ? '}' : ']'))
+    {
+        return JSCONE_FAILURE;
+    }
+
+    return jscone_cursor_read_element(cursor, &lexer, open == '{');
+}
+
+int jscone_cursor_next_element(JsconeCursor* cursor)
+{
+    JsconeLexer lexer = jscone_cursor_lexer(cursor);
+    if(jscone_cursor_skip(&lexer) == JSCONE_FAILURE || jscone_lexer_next_token(&lexer) == JSCONE_FAILURE)
+    {
+        return JSCONE_FAILURE;
+    }
+
+    switch(JSCONE_LEXER_GET_FIRST_CHAR(&lexer))
+    {
+        case ',':
+            break;
+        case '}': case ']': case '\0':
+            return JSCONE_FAILURE;
+        default:
+            JSCONE_LEXER_ERROR(&lexer, JSCONE_ERROR_SYNTAX, "expected char , between values");
+            return JSCONE_FAILURE;
+    }
+
+    if(jscone_lexer_next_token(&lexer) == JSCONE_FAILURE)
+    {
+        return JSCONE_FAILURE;
+    }
+
+    return jscone_cursor_read_element(cursor, &lexer, cursor->in_object);
+}
+
+const char* jscone_cursor_name(const JsconeCursor* cursor, size_t* length)
+{
+    if(cursor->name_first == cursor->name_end)
+    {
+        return NULL;
+    }
+
+    if(length != NULL)
+    {
+        *length = cursor->name_end - cursor->name_first - 2;
+    }
+    return cursor->json + cursor->name_first + 1;
+}
+
+int jscone_cursor_get_double(const JsconeCursor* cursor, double* num)
+{
+    JsconeType type;
+    JsconeVal value;
+    if(jscone_cursor_type(cursor) != JSCONE_NUM
+       || jscone_number_parse(cursor->json + cursor->first, cursor->end - cursor->first, &type, &value) == JSCONE_FAILURE)
+    {
+        return JSCONE_FAILURE;
+    }
+
+    *num = type == JSCONE_INT ? (double)value.integer : value.num;
+    return JSCONE_SUCCESS;
+}
+
+int jscone_cursor_get_int(const JsconeCursor* cursor, int64_t* integer)
+{
+    JsconeType type;
+    JsconeVal value;
+    if(jscone_cursor_type(cursor) != JSCONE_NUM
+       || jscone_number_parse(cursor->json + cursor->first, cursor->end - cursor->first, &type, &value) == JSCONE_FAILURE)
+    {
+        return JSCONE_FAILURE;
+    }
+
+    if(type == JSCONE_INT)
+    {
+        *integer = value.integer;
+        return JSCONE_SUCCESS;
+    }
+
+    /* doubles only if they are whole numbers */
+    if(value.num < -(double)JSCONE_MAX_EXACT_INT || value.num > (double)JSCONE_MAX_EXACT_INT
+       || value.num != (double)(int64_t)value.num)
+    {
+        return JSCONE_FAILURE;
+    }
+
+    *integer = (int64_t)value.num;
+    return JSCONE_SUCCESS;
+}
+
+int jscone_cursor_get_bool(const JsconeCursor* cursor, unsigned char* value)
+{
+    const char* token = cursor->json + cursor->first;
+    size_t length = cursor->end - cursor->first;
+    if(length == 4 && strncmp(token, "true", 4) == 0)
+    {
+        *value = JSCONE_TRUE;
+        return JSCONE_SUCCESS;
+    }
+    if(length == 5 && strncmp(token, "false", 5) == 0)
+    {
+        *value = JSCONE_FALSE;
+        return JSCONE_SUCCESS;
+    }
+
+    return JSCONE_FAILURE;
+}
+
+char* jscone_cursor_get_string(const JsconeCursor* cursor)
+{
+    if(cursor->json[cursor->first] != '\"')
+    {
+        return NULL;
+    }
+
+    JsconeParser parser = {
+        .lexer = jscone_cursor_lexer(cursor),
+        .curr_node = NULL,
+    };
+    parser.lexer.curr.first++; // move past first "
+
+    return jscone_parser_get_string(&parser);
+}
+
+void jscone_string_free(char* str)
+{
+    JSCONE_MEM_FREE(str);
+}
+
+void jscone_print(JsconeNode* node)
+{
+    if(node == NULL)
+    {
+        return;
+    }
+
+    jscone_node_print(node, 0);
+}
+
+int jscone_write(const JsconeNode* node, JsconeBuffer* buf, const JsconeWriteOptions* options)
+{
+    if(node == NULL || buf == NULL)
+    {
+        return JSCONE_FAILURE;
+    }
+
+    unsigned int indent = options != NULL ? options->indent : 0;
+    unsigned int depth = 0;
+    const JsconeNode* top = node;
+
+    /* goes down with child and back up with parent like jscone_node_print() */
+    while(JSCONE_TRUE)
+    {
+        if(node != top)
+        {
+            if(node->prev != NULL && jscone_buffer_append(buf, ",", 1) == JSCONE_FAILURE)
+            {
+                return JSCONE_FAILURE;
+            }
+            if(jscone_write_newline(buf, indent, depth) == JSCONE_FAILURE)
+            {
+                return JSCONE_FAILURE;
+            }
+
+            if(node->parent->type == JSCONE_OBJECT)
+            {
+                const char* name = node->name != NULL ? node->name : "";
+                if(jscone_write_string(buf, name, strlen(name)) == JSCONE_FAILURE
+                || jscone_buffer_append(buf, ": ", indent != 0 ? 2 : 1) == JSCONE_FAILURE)
+                {
+                    return JSCONE_FAILURE;
+                }
+            }
+        }
+
+        int ret;
+        switch(node->type)
+        {
+            case JSCONE_OBJECT: case JSCONE_ARRAY:
+                ret = jscone_buffer_append(buf, node->type == JSCONE_OBJECT ? "{" : "[", 1);
+                if(ret == JSCONE_SUCCESS && node->child != NULL)
+                {
+                    node = node->child;
+                    depth++;
+                    continue;
+                }
+                ret = ret == JSCONE_FAILURE ? ret : jscone_buffer_append(buf, node->type == JSCONE_OBJECT ? "}" : "]", 1);
+                break;
+            case JSCONE_STRING:
+                if(node->flags & JSCONE_NODE_RAW)
+                {
+                    /* still escaped the same as in the json */
+                    ret = jscone_buffer_reserve(buf, node->value.slice->length + 2);
+                    if(ret == JSCONE_SUCCESS)
+                    {
+                        buf->data[buf->length++] = '\"';
+                        memcpy(buf->data + buf->length, node->value.slice->str, node->value.slice->length);
+                        buf->length += node->value.slice->length;
+                        buf->data[buf->length++] = '\"';
+                    }
+                    break;
+                }
+                ret = jscone_write_string(buf, node->value.str, strlen(node->value.str));
+                break;
+            case JSCONE_NUM:
+                ret = jscone_write_number(buf, node->value.num);
+                break;
+            case JSCONE_INT:
+                ret = jscone_write_integer(buf, node->value.integer);
+                break;
+            case JSCONE_BOOL:
+                ret = node->value.bool ? jscone_buffer_append(buf, "true", 4) : jscone_buffer_append(buf, "false", 5);
+                break;
+            default:
+                ret = jscone_buffer_append(buf, "null", 4);
+                break;
+        }
+        if(ret == JSCONE_FAILURE)
+        {
+            return JSCONE_FAILURE;
+        }
+
+        /* close objects/arrays until one has a next sibling */
+        while(node != top && node->next == NULL)
+        {
+            node = node->parent;
+            depth--;
+            if(jscone_write_newline(buf, indent, depth) == JSCONE_FAILURE
+            || jscone_buffer_append(buf, node->type == JSCONE_OBJECT ? "}" : "]", 1) == JSCONE_FAILURE)
+            {
+                return JSCONE_FAILURE;
+            }
+        }
+        if(node == top)
+        {
+            break;
+        }
+        node = node->next;
+    }
+
+    /* \0 isn't counted in length */
+    if(jscone_buffer_reserve(buf, 1) == JSCONE_FAILURE)
+    {
+        return JSCONE_FAILURE;
+    }
+    buf->data[buf->length] = '\0';
+    return JSCONE_SUCCESS;
+}
+
+int jscone_write_file(const JsconeNode* node, const char* path, const JsconeWriteOptions* options)
+{
+    JsconeBuffer buf = {0};
+    if(jscone_write(node, &buf, options) == JSCONE_FAILURE)
+    {
+        jscone_buffer_free(&buf);
+        return JSCONE_FAILURE;
+    }
+
+    FILE* file = fopen(path, "wb");
+    if(file == NULL)
+    {
+        JSCONE_ERROR(JSCONE_ERROR_FILE, "could not open file");
+        jscone_buffer_free(&buf);
+        return JSCONE_FAILURE;
+    }
+
+    int ret = fwrite(buf.data, 1, buf.length, file) == buf.length ? JSCONE_SUCCESS : JSCONE_FAILURE;
+    if(fclose(file) != 0)
+    {
+        ret = JSCONE_FAILURE;
+    }
+    if(ret == JSCONE_FAILURE)
+    {
+        JSCONE_ERROR(JSCONE_ERROR_FILE, "could not write file");
+    }
+
+    jscone_buffer_free(&buf);
+    return ret;
+}
+
+void jscone_buffer_free(JsconeBuffer* buf)
+{
+    if(buf == NULL)
+    {
+        return;
+    }
+
+    JSCONE_MEM_FREE(buf->data);
+    buf->data = NULL;
+    buf->length = 0;
+    buf->capacity = 0;
+}
+
+void jscone_set_allocator(const JsconeAllocator* allocator)
+{
+    jscone_allocator = allocator != NULL ? allocator : &jscone_default_allocator;
+}
+
+JsconeError jscone_last_error(void)
+{
+    return jscone_error;
+}
+
+int jscone_error_position(const char* json, size_t length, const JsconeError* error, size_t* line, size_t* column)
+{
+    if(error->byte_offset > length)
+    {
+        return JSCONE_FAILURE;
+    }
+
+    /* lines are only counted here, so parsing doesn't pay for it */
+    size_t line_num = 1;
+    size_t line_start = 0;
+    const char* newline = json;
+    while((newline = memchr(newline, '\n', error->byte_offset - (size_t)(newline - json))) != NULL)
+    {
+        line_num++;
+        line_start = (size_t)(++newline - json);
+    }
+
+    if(line != NULL)
+    {
+        *line = line_num;
+    }
+    if(column != NULL)
+    {
+        *column = error->byte_offset - line_start + 1;
+    }
+    return JSCONE_SUCCESS;
+}
+
+void jscone_set_log(JsconeLogFunc log, void* user)
+{
+    jscone_log = log;
+    jscone_log_user = user;
+}
+
+void jscone_log_stderr(void* user, const JsconeError* error)
+{
+    (void)user;
+    fprintf(stderr, "[JSCONE]: at byte %llu: %s\n", (unsigned long long)error->byte_offset, error->message);
+}
+
+
+
+/**
+ * internal functions
+ */
+
+JsconeNode* jscone_find_name_in_siblings(JsconeParser* parser, const char* name)
+{
+    JsconeNode* parent = parser->curr_node->parent;
+    if(parent != NULL && parent->type == JSCONE_ARRAY)
+    {
+        /* values in arrays don't have names of their own, only indexes into the whole array */
+        size_t index = jscone_path_index(name);
+        if(index == JSCONE_PATH_NO_INDEX || parser->curr_node->prev != NULL)
+        {
+            JSCONE_PARSER_ERROR(parser, JSCONE_ERROR_NOT_FOUND, "arrays can only be searched with an index");
+            return NULL;
+        }
+
+        JsconeNode* node = jscone_array_get(parent, index);
+        if(node == NULL)
+        {
+            JSCONE_PARSER_ERROR(parser, JSCONE_ERROR_NOT_FOUND, "index is out of range");
+            return NULL;
+        }
+
+        parser->curr_node = node;
+        return node;
+    }
+
+    /* whole object is searched so its hash table can be used */
+    if(parser->curr_node->prev == NULL && parent != NULL && parent->type == JSCONE_OBJECT)
+    {
+        JsconeNode* node = jscone_get_member(parent, name, strlen(name));
+        if(node == NULL)
+        {
+            JSCONE_PARSER_ERROR(parser, JSCONE_ERROR_NOT_FOUND, "could not find name");
+            return NULL;
+        }
+
+        parser->curr_node = node;
+        return node;
+    }
+
+    while(JSCONE_TRUE)
+    {
+        if(parser->curr_node->name != NULL && strcmp(name, parser->curr_node->name) == 0) // root has no name
+        {
+            return parser->curr_node;
+        }
+
+        if(parser->curr_node->next == NULL)
+        {
+            JSCONE_PARSER_ERROR(parser, JSCONE_ERROR_NOT_FOUND, "could not find name");
+            return NULL;
+        }
+
+        parser->curr_node = parser->curr_node->next;
+    }
+
+    return NULL; // should not be reached
+}
+
+uint64_t jscone_hash(const char* key, size_t length)
+{
+    /* FNV-1a */
+    uint64_t hash = 0xcbf29ce484222325ull;
+    for(size_t i = 0; i < length; i++)
+    {
+        hash ^= (unsigned char)key[i];
+        hash *= 0x100000001b3ull;
+    }
+
+    return hash;
+}
+
+int jscone_members_build(JsconeNode* object, JsconeArena* arena)
+{
+    /* at most half full */
+    size_t capacity = 1;
+    while(capacity < object->count * 2)
+    {
+        capacity <<= 1;
+    }
+
+    size_t size = sizeof(JsconeMembers) + capacity * sizeof(JsconeMemberSlot);
+    JsconeMembers* members;
+    if(arena != NULL)
+    {
+        members = (JsconeMembers*)jscone_arena_alloc(arena, size, JSCONE_ARENA_ALIGN);
+    }
+    else
+    {
+        members = (JsconeMembers*)JSCONE_MEM_ALLOC(size);
+    }
+
+    if(members == NULL)
+    {
+        return JSCONE_FAILURE;
+    }
+
+    members->capacity = capacity;
+    members->slots = (JsconeMemberSlot*)(members + 1);
+    memset(members->slots, 0, capacity * sizeof(JsconeMemberSlot));
+
+    size_t mask = capacity - 1;
+    for(JsconeNode* child = object->child; child != NULL; child = child->next)
+    {
+        if(child->name == NULL)
+        {
+            continue;
+        }
+
+        size_t length = strlen(child->name);
+        uint64_t hash = jscone_hash(child->name, length);
+        size_t i = (size_t)hash & mask;
+        while(members->slots[i].node != NULL)
+        {
+            if(members->slots[i].hash == hash && strcmp(members->slots[i].node->name, child->name) == 0)
+            {
+                break; // duplicate name, keep the first like a linear search would
+            }
+            i = (i + 1) & mask;
+        }
+
+        if(members->slots[i].node == NULL)
+        {
+            members->slots[i].node = child;
+            members->slots[i].hash = hash;
+        }
+    }
+
+    object->value.members = members;
+    object->flags |= JSCONE_NODE_HASHED;
+    return JSCONE_SUCCESS;
+}
+
+JsconeNode* jscone_members_find(const JsconeMembers* members, const char* key, size_t length, uint64_t hash)
+{
+    size_t mask = members->capacity - 1;
+    for(size_t i = (size_t)hash & mask; members->slots[i].node != NULL; i = (i + 1) & mask)
+    {
+        if(members->slots[i].hash == hash && jscone_name_equals(members->slots[i].node->name, key, length))
+        {
+            return members->slots[i].node;
+        }
+    }
+
+    return NULL;
+}
+
+JsconeNode* jscone_path_find_sibling(JsconeNode* node, const JsconePathSegment* segment)
+{
+    if(node == NULL)
+    {
+        return NULL;
+    }
+
+    JsconeNode* parent = node->parent;
+    if(parent != NULL && parent->type == JSCONE_ARRAY)
+    {
+        /* same as jscone_find(), values in arrays are only found by index */
+        return node->prev == NULL && segment->index != JSCONE_PATH_NO_INDEX ? jscone_array_at(parent, segment->index) : NULL;
+    }
+
+    /* whole object is searched so its hash table can be used */
+    if(node->prev == NULL && parent != NULL && (parent->flags & JSCONE_NODE_HASHED))
+    {
+        return jscone_members_find(parent->value.members, segment->name, segment->length, segment->hash);
+    }
+
+    for(; node != NULL; node = node->next)
+    {
+        if(segment->symbol != 0 && (node->flags & JSCONE_NODE_INTERNED))
+        {
+            if(jscone_node_symbol(node) == segment->symbol)
+            {
+                return node;
+            }
+        }
+        else if(node->name != NULL && jscone_name_equals(node->name, segment->name, segment->length))
+        {
+            return node;
+        }
+    }
+
+    return NULL;
+}
+
+int jscone_elements_build(JsconeNode* arr, JsconeArena* arena)
+{
+    /* arena vectors are never added to, others have room up to the next power of 2 */
+    size_t capacity = 1;
+    if(arena != NULL)
+    {
+        capacity = arr->count > 0 ? arr->count : 1;
+    }
+    else
+    {
+        while(capacity < arr->count)
+        {
+            capacity <<= 1;
+        }
+    }
+
+    JsconeNode** elements;
+    if(arena != NULL)
+    {
+        elements = (JsconeNode**)jscone_arena_alloc(arena, capacity * sizeof(JsconeNode*), JSCONE_ARENA_ALIGN);
+    }
+    else
+    {
+        elements = (JsconeNode**)JSCONE_MEM_ALLOC(capacity * sizeof(JsconeNode*));
+    }
+
+    if(elements == NULL)
+    {
+        return JSCONE_FAILURE;
+    }
+
+    size_t i = 0;
+    for(JsconeNode* child = arr->child; child != NULL; child = child->next)
+    {
+        elements[i++] = child;
+    }
+
+    arr->value.elements = elements;
+    arr->flags |= JSCONE_NODE_INDEXED;
+    return JSCONE_SUCCESS;
+}
+
+void jscone_elements_add(JsconeNode* arr, JsconeNode* node)
+{
+    size_t count = arr->count;
+    if(!(arr->flags & JSCONE_NODE_ARENA))
+    {
+        /* full when count is a power of 2 */
+        if(count == 0 || (count & (count - 1)) != 0)
+        {
+            arr->value.elements[count] = node;
+            return;
+        }
+
+        JsconeNode** elements = (JsconeNode**)JSCONE_MEM_REALLOC(arr->value.elements, count * 2 * sizeof(JsconeNode*));
+        if(elements != NULL)
+        {
+            elements[count] = node;
+            arr->value.elements = elements;
+            return;
+        }
+        JSCONE_MEM_FREE(arr->value.elements);
+    }
+
+    /* made again on next jscone_array_get() if it can be */
+    arr->value.elements = NULL;
+    arr->flags &= ~(unsigned int)JSCONE_NODE_INDEXED;
+}
+
+JsconeNode* jscone_array_at(const JsconeNode* arr, size_t index)
+{
+    if(index >= arr->count)
+    {
+        return NULL;
+    }
+    if(arr->flags & JSCONE_NODE_INDEXED)
+    {
+        return arr->value.elements[index];
+    }
+
+    JsconeNode* node = arr->child;
+    for(size_t i = 0; i < index; i++)
+    {
+        node = node->next;
+    }
+    return node;
+}
+
+size_t jscone_path_index(const char* name)
+{
+    /* small enough to not overflow */
+    size_t length = strlen(name);
+    if(length == 0 || length > 18)
+    {
+        return JSCONE_PATH_NO_INDEX;
+    }
+
+    size_t index = 0;
+    for(size_t i = 0; i < length; i++)
+    {
+        if(!JSCONE_IS_DIGIT(name[i]))
+        {
+            return JSCONE_PATH_NO_INDEX;
+        }
+        index = index * 10 + (size_t)(name[i] - '0');
+    }
+
+    return index;
+}
+
+unsigned char jscone_name_equals(const char* name, const char* key, size_t length)
+{
+    return strncmp(name, key, length) == 0 && name[length] == '\0';
+}
+
+char* jscone_find_next_name(JsconeParser* parser, char* terminator)
+{
+    const char* path = parser->lexer.json;
+    unsigned char escaped = JSCONE_FALSE;
+    char c;
+
+    /* find end of name, / can be escaped */
+    for(;; parser->lexer.curr.end++)
+    {
+        c = path[parser->lexer.curr.end];
+        if(c == '\\')
+        {
+            escaped = !escaped;
+            continue;
+        }
+        if((c == '/' || c == '\0') && !escaped)
+        {
+            break;
+        }
+        escaped = JSCONE_FALSE;
+    }
+
+    *terminator = c;
+    char* name = jscone_parser_get_string(parser);
+
+    /* move ahead of / */
+    parser->lexer.curr.first = parser->lexer.curr.end + 1;
+    parser->lexer.curr.end = parser->lexer.curr.first;
+    return name;
+}
+
+/* parsing */
+
+JsconeDocument* jscone_document_create(const char* json, size_t length, const JsconeOptions* options, char* insitu)
+{
+    /* guess enough space so most documents fit in one or two blocks */
+    size_t block_size = (options != NULL && options->block_size != 0) ? options->block_size : JSCONE_ARENA_GUESS(length * 2);
+
+    JsconeArena arena;
+    if(jscone_arena_init(&arena, block_size) == JSCONE_FAILURE)
+    {
+        JSCONE_ERROR(JSCONE_ERROR_MEMORY, "could not allocate document");
+        return NULL;
+    }
+
+    /* document lives in its own first block */
+    JsconeDocument* doc = (JsconeDocument*)jscone_arena_alloc(&arena, sizeof(JsconeDocument), JSCONE_ARENA_ALIGN);
+    if(doc == NULL)
+    {
+        jscone_arena_free(&arena);
+        return NULL;
+    }
+    doc->root = NULL;
+    doc->arena = arena;
+    doc->file = NULL;
+    doc->file_size = 0;
+
+    JsconeParser parser = {
+        .lexer = {
+            .json = json,
+            .length = length,
+            .curr = {.first = 0, .end = 0},
+        },
+        .curr_node = NULL,
+        .arena = &doc->arena,
+        .insitu = insitu,
+        .flags = options != NULL ? options->flags : 0,
+        .symbols = options != NULL ? options->symbols : NULL,
+        .max_depth = options != NULL ? options->max_depth : 0,
+    };
+
+    if(jscone_parser_parse_root(&parser) == JSCONE_FAILURE)
+    {
+        jscone_document_free(doc);
+        return NULL;
+    }
+
+    doc->root = parser.curr_node;
+    return doc;
+}
+
+int jscone_parser_parse_root(JsconeParser* parser)
+{
+    /* tokens come from the structural index instead of scanning bytes */
+    size_t positions[JSCONE_INDEX_CAPACITY];
+    JsconeIndex index;
+    jscone_index_init(&index, positions, JSCONE_INDEX_CAPACITY);
+    index.validate_utf8 = (parser->flags & JSCONE_VALIDATE_UTF8) != 0;
+    parser->lexer.index = &index;
+
+    int ret = JSCONE_FAILURE;
+    jscone_error = (JsconeError){.code = JSCONE_ERROR_NONE, .byte_offset = 0, .message = ""};
+
+    /* go to first token */
+    if(jscone_lexer_next_token(&parser->lexer) == JSCONE_FAILURE)
+    {
+        goto end;
+    }
+    
+    if(JSCONE_PARSER_GET_FIRST_CHAR(parser) == '{')
+    {
+        if(jscone_parser_parse_object(parser, NULL) == JSCONE_FAILURE) // will return the root node
+        {
+            goto end;
+        }
+    }
+    else if(JSCONE_PARSER_GET_FIRST_CHAR(parser) == '[')
+    {
+        if(jscone_parser_parse_array(parser, NULL) == JSCONE_FAILURE) // will return the root node
+        {
+            goto end;
+        }
+    }
+    else
+    {
+        JSCONE_PARSER_ERROR(parser, JSCONE_ERROR_SYNTAX, "first character not { or [");
+        goto end;
+    }
+
+    /* check for extra characters after json end, only whitespace is allowed */
+    if(jscone_lexer_next_token(&parser->lexer) == JSCONE_FAILURE)
+    {
+        goto end;
+    }
+    if(parser->lexer.curr.first != parser->lexer.curr.end)
+    {
+        JSCONE_PARSER_ERROR(parser, JSCONE_ERROR_SYNTAX, "extra characters after JSON end");
+        goto end;
+    }
+
+    ret = JSCONE_SUCCESS;
+
+    end:
+    parser->lexer.index = NULL; // index is on this stack frame
+
+    /* everything else records its own error */
+    if(ret == JSCONE_FAILURE && jscone_error.code == JSCONE_ERROR_NONE)
+    {
+        JSCONE_PARSER_ERROR(parser, JSCONE_ERROR_MEMORY, "out of memory");
+    }
+    return ret;
+}
+
+int jscone_parser_parse_range(JsconeParser* parser, JsconeType type)
+{
+    /* values between two top-level commas with no brackets around them, for jscone_parse_parallel() */
+    size_t positions[JSCONE_INDEX_CAPACITY];
+    JsconeIndex index;
+    jscone_index_init(&index, positions, JSCONE_INDEX_CAPACITY);
+    index.validate_utf8 = (parser->flags & JSCONE_VALIDATE_UTF8) != 0;
+    parser->lexer.index = &index;
+
+    int ret = JSCONE_FAILURE;
+    if(jscone_lexer_next_token(&parser->lexer) == JSCONE_SUCCESS)
+    {
+        ret = jscone_parser_parse_members(parser, type, NULL, '\0');
+    }
+
+    parser->lexer.index = NULL; // index is on this stack frame
+    return ret;
+}
+
+int jscone_parser_parse_value(JsconeParser* parser, const char* name)
+{
+    /* determine type */
+    switch(JSCONE_PARSER_GET_FIRST_CHAR(parser))
+    {
+        case '{':
+            return jscone_parser_parse_object(parser, name);
+        case '[':
+            return jscone_parser_parse_array(parser, name);
+        case '\"':
+            return jscone_parser_parse_string(parser, name);
+        case '0': case '1': case '2': case '3': case '4':
+        case '5': case '6': case '7': case '8': case '9':
+        case '-': case '.':
+            return jscone_parser_parse_number(parser, name);
+        default:
+            return jscone_parser_parse_enum(parser, name);
+    }
+
+    return JSCONE_FAILURE; // should not be reached
+}
+
+int jscone_parser_parse_object(JsconeParser* parser, const char* name)
+{
+    if(jscone_parser_begin_node(parser, JSCONE_OBJECT, name) == JSCONE_FAILURE)
+    {
+        return JSCONE_FAILURE;
+    }
+
+    /* caller should have already gone to next token */
+    JSCONE_EXPECT_FIRST_CHAR(parser, '{', "missing opening bracket for object");
+    JSCONE_PARSER_NEXT_TOKEN(parser);
+    if(jscone_parser_parse_members(parser, JSCONE_OBJECT, name, '}') == JSCONE_FAILURE)
+    {
+        return JSCONE_FAILURE;
+    }
+
+    return jscone_parser_end_node(parser, JSCONE_OBJECT);
+}
+
+int jscone_parser_parse_array(JsconeParser* parser, const char* name)
+{
+    if(jscone_parser_begin_node(parser, JSCONE_ARRAY, name) == JSCONE_FAILURE)
+    {
+        return JSCONE_FAILURE;
+    }
+
+    /* caller should have already gone to next token */
+    JSCONE_EXPECT_FIRST_CHAR(parser, '[', "missing opening bracket for array");
+    JSCONE_PARSER_NEXT_TOKEN(parser);
+    if(jscone_parser_parse_members(parser, JSCONE_ARRAY, name, ']') == JSCONE_FAILURE)
+    {
+        return JSCONE_FAILURE;
+    }
+
+    return jscone_parser_end_node(parser, JSCONE_ARRAY);
+}
+
+int jscone_parser_parse_members(JsconeParser* parser, JsconeType type, const char* name, char close)
+{
+    /* nested objects/arrays go on a stack instead of recursing */
+    JsconeLevel local[JSCONE_PARSER_STACK_SIZE];
+    JsconeLevels stack = {
+        .levels = local,
+        .depth = 0,
+        .capacity = JSCONE_PARSER_STACK_SIZE,
+        .max_depth = parser->max_depth != 0 ? parser->max_depth : JSCONE_DEFAULT_MAX_DEPTH,
+        .local = local,
+    };
+    if(parser->levels != NULL && parser->levels->levels != NULL)
+    {
+        /* carry on with the heap stack from the last parse */
+        stack.levels = parser->levels->levels;
+        stack.capacity = parser->levels->capacity;
+    }
+    jscone_levels_push(&stack, type, name); // always fits
+
+    int ret = jscone_parser_parse_levels(parser, &stack, close);
+
+    if(stack.levels != local)
+    {
+        if(parser->levels != NULL)
+        {
+            parser->levels->levels = stack.levels;
+            parser->levels->capacity = stack.capacity;
+        }
+        else
+        {
+            JSCONE_MEM_FREE(stack.levels);
+        }
+    }
+    return ret;
+}
+
+int jscone_parser_parse_levels(JsconeParser* parser, JsconeLevels* stack, char close)
+{
+    while(JSCONE_TRUE)
+    {
+        JsconeLevel* level = &stack->levels[stack->depth - 1];
+        char level_close = stack->depth == 1 ? close : (level->type == JSCONE_OBJECT ? '}' : ']');
+
+        if(JSCONE_PARSER_GET_FIRST_CHAR(parser) == level_close)
+        {
+            /* caller ends the first level */
+            if(stack->depth == 1)
+            {
+                return JSCONE_SUCCESS;
+            }
+
+            if(jscone_parser_end_node(parser, level->type) == JSCONE_FAILURE)
+            {
+                return JSCONE_FAILURE;
+            }
+            stack->depth--;
+        }
+        else
+        {
+            /* keep all names same in array */
+            char* curr_name = (char*)level->name;
+            if(level->type == JSCONE_OBJECT)
+            {
+                JSCONE_EXPECT_FIRST_CHAR(parser, '\"', "object name string is missing first quote");
+                JSCONE_EXPECT_LAST_CHAR(parser, '\"', "object name string is missing last quote");
+
+                curr_name = jscone_parser_parse_name(parser);
+                if(curr_name == NULL)
+                {
+                    return JSCONE_FAILURE;
+                }
+
+                /* name is only owned by the value's node once it is made */
+                if(jscone_lexer_next_token(&parser->lexer) == JSCONE_FAILURE || JSCONE_PARSER_GET_FIRST_CHAR(parser) != ':')
+                {
+                    JSCONE_PARSER_ERROR(parser, JSCONE_ERROR_SYNTAX, "expected char :");
+                    jscone_parser_free(parser, curr_name);
+                    return JSCONE_FAILURE;
+                }
+                if(jscone_lexer_next_token(&parser->lexer) == JSCONE_FAILURE)
+                {
+                    jscone_parser_free(parser, curr_name);
+                    return JSCONE_FAILURE;
+                }
+            }
+
+            char c = JSCONE_PARSER_GET_FIRST_CHAR(parser);
+            if(c == '{' || c == '[')
+            {
+                /* pushing can move the stack, level isn't valid after it */
+                JsconeType outer = level->type;
+                JsconeType type = c == '{' ? JSCONE_OBJECT : JSCONE_ARRAY;
+                if(jscone_levels_push(stack, type, curr_name) == JSCONE_FAILURE)
+                {
+                    if(stack->depth == stack->max_depth)
+                    {
+                        JSCONE_PARSER_ERROR(parser, JSCONE_ERROR_DEPTH, "nested deeper than the max depth");
+                    }
+                    else
+                    {
+                        JSCONE_PARSER_ERROR(parser, JSCONE_ERROR_MEMORY, "out of memory");
+                    }
+                    if(outer == JSCONE_OBJECT)
+                    {
+                        jscone_parser_free(parser, curr_name);
+                    }
+                    return JSCONE_FAILURE;
+                }
+
+                if(jscone_parser_begin_node(parser, type, curr_name) == JSCONE_FAILURE)
+                {
+                    if(outer == JSCONE_OBJECT)
+                    {
+                        jscone_parser_free(parser, curr_name);
+                    }
+                    return JSCONE_FAILURE;
+                }
+
+                JSCONE_PARSER_NEXT_TOKEN(parser);
+                continue; // no comma until it ends
+            }
+
+            if(jscone_parser_parse_value(parser, curr_name) == JSCONE_FAILURE)
+            {
+                if(level->type == JSCONE_OBJECT)
+                {
+                    jscone_parser_free(parser, curr_name);
+                }
+                return JSCONE_FAILURE;
+            }
+        }
+
+        /* after a value, level may have just ended */
+        level = &stack->levels[stack->depth - 1];
+        level_close = stack->depth == 1 ? close : (level->type == JSCONE_OBJECT ? '}' : ']');
+
+        JSCONE_PARSER_NEXT_TOKEN(parser);
+        if(JSCONE_PARSER_GET_FIRST_CHAR(parser) == ',')
+        {
+            JSCONE_PARSER_NEXT_TOKEN(parser);
+            if(JSCONE_PARSER_GET_FIRST_CHAR(parser) == level_close)
+            {
+                JSCONE_PARSER_ERROR(parser, JSCONE_ERROR_SYNTAX, "trailing comma before closing bracket");
+                return JSCONE_FAILURE;
+            }
+        }
+        else
+        {
+            JSCONE_EXPECT_FIRST_CHAR(parser, level_close, "missing comma or closing brace for object");
+        }
+    }
+}
+
+int jscone_levels_push(JsconeLevels* stack, JsconeType type, const char* name)
+{
+    if(stack->depth == stack->max_depth)
+    {
+        return JSCONE_FAILURE;
+    }
+
+    if(stack->depth == stack->capacity)
+    {
+        size_t capacity = stack->capacity * 2;
+        JsconeLevel* levels;
+        if(stack->levels == stack->local)
+        {
+            levels = (JsconeLevel*)JSCONE_MEM_ALLOC(capacity * sizeof(JsconeLevel));
+            if(levels != NULL)
+            {
+                memcpy(levels, stack->levels, stack->depth * sizeof(JsconeLevel));
+            }
+        }
+        else
+        {
+            levels = (JsconeLevel*)JSCONE_MEM_REALLOC(stack->levels, capacity * sizeof(JsconeLevel));
+        }
+
+        if(levels == NULL)
+        {
+            return JSCONE_FAILURE;
+        }
+        stack->levels = levels;
+        stack->capacity = capacity;
+    }
+
+    stack->levels[stack->depth++] = (JsconeLevel){.type = type, .name = name};
+    return JSCONE_SUCCESS;
+}
+
+char* jscone_parser_parse_name(JsconeParser* parser)
+{
+    if(parser->symbols != NULL)
+    {
+        /* names without escapes can be looked up straight from the json */
+        const char* raw = parser->lexer.json + parser->lexer.curr.first + 1;
+        size_t length = JSCONE_PARSER_TOKEN_LENGTH(parser) - 2;
+        if(memchr(raw, '\\', length) == NULL)
+        {
+            return (char*)jscone_symbols_intern(parser->symbols, raw, length);
+        }
+
+        parser->lexer.curr.first++;
+        char* name = jscone_parser_get_string(parser);
+        return name == NULL ? NULL : (char*)jscone_symbols_intern(parser->symbols, name, strlen(name));
+    }
+
+    parser->lexer.curr.first++; // move past first "
+    char* name = jscone_parser_get_string(parser);
+
+    if(name != NULL && parser->tape != NULL)
+    {
+        size_t offset = (size_t)(name - parser->tape->strings) - sizeof(size_t);
+        if(jscone_tape_push(parser->tape, JSCONE_TAPE_KEY, offset) == JSCONE_FAILURE)
+        {
+            return NULL;
+        }
+        parser->tape->keyed = JSCONE_TRUE;
+    }
+    else if(name != NULL && parser->events != NULL)
+    {
+        JsconeEvents* events = parser->events;
+        if(JSCONE_EVENT(events, key, events->user, name, events->length) == JSCONE_FAILURE)
+        {
+            return NULL;
+        }
+    }
+
+    return name;
+}
+
+int jscone_parser_parse_string(JsconeParser* parser, const char* name)
+{
+    if(parser->flags & JSCONE_LAZY_STRINGS)
+    {
+        return jscone_parser_add_slice(parser, name);
+    }
+
+    parser->lexer.curr.first++; // move past first "
+    char* string = jscone_parser_get_string(parser);
+    if(string == NULL)
+    {
+        return JSCONE_FAILURE;
+    }
+
+    return jscone_parser_add_value(parser, JSCONE_STRING, (JsconeVal){.str = string}, name);
+}
+
+int jscone_parser_add_slice(JsconeParser* parser, const char* name)
+{
+    JsconeSlice* slice = (JsconeSlice*)jscone_arena_alloc(parser->arena, sizeof(JsconeSlice), JSCONE_ARENA_ALIGN);
+    if(slice == NULL)
+    {
+        return JSCONE_FAILURE;
+    }
+
+    /* between the quotes */
+    slice->str = parser->lexer.json + parser->lexer.curr.first + 1;
+    slice->length = JSCONE_PARSER_TOKEN_LENGTH(parser) - 2;
+
+    JsconeNode* node = jscone_parser_create_node(parser, JSCONE_STRING, (JsconeVal){.slice = slice}, name);
+    if(node == NULL)
+    {
+        return JSCONE_FAILURE;
+    }
+
+    node->flags |= JSCONE_NODE_RAW;
+    if(memchr(slice->str, '\\', slice->length) != NULL)
+    {
+        node->flags |= JSCONE_NODE_ESCAPED;
+    }
+
+    return JSCONE_SUCCESS;
+}
+
+int jscone_parser_parse_number(JsconeParser* parser, const char* name)
+{
+    const char* str = parser->lexer.json + parser->lexer.curr.first;
+    size_t length = JSCONE_PARSER_TOKEN_LENGTH(parser);
+
+    JsconeType type;
+    JsconeVal value;
+    if(jscone_number_parse(str, length, &type, &value) == JSCONE_FAILURE)
+    {
+        JSCONE_PARSER_ERROR(parser, JSCONE_ERROR_NUMBER, "invalid number");
+        return JSCONE_FAILURE;
+    }
+
+    return jscone_parser_add_value(parser, type, value, name);
+}
+
+int jscone_number_parse(const char* str, size_t length, JsconeType* type, JsconeVal* value)
+{
+    static const double powers_of_10[JSCONE_MAX_EXACT_POW10 + 1] = {
+        1e0,  1e1,  1e2,  1e3,  1e4,  1e5,  1e6,  1e7,  1e8,  1e9,  1e10, 1e11,
+        1e12, 1e13, 1e14, 1e15, 1e16, 1e17, 1e18, 1e19, 1e20, 1e21, 1e22,
+    };
+
+    size_t i = 0;
+
+    /* read the first 19 significant digits into mantissa, the rest only move the exponent */
+    uint64_t mantissa = 0;
+    int digits = 0;
+    int exponent = 0;
+    unsigned char truncated = JSCONE_FALSE;
+    unsigned char is_integer = JSCONE_TRUE;
+
+    unsigned char negative = str[0] == '-';
+    i += negative;
+
+    if(i == length || !JSCONE_IS_DIGIT(str[i]))
+    {
+        return JSCONE_FAILURE;
+    }
+
+    if(str[i] == '0')
+    {
+        i++; // no leading zeroes
+    }
+    else
+    {
+        for(; i < length && JSCONE_IS_DIGIT(str[i]); i++)
+        {
+            if(digits < JSCONE_MAX_MANTISSA_DIGITS)
+            {
+                mantissa = mantissa * 10 + (uint64_t)(str[i] - '0');
+                digits++;
+            }
+            else
+            {
+                truncated |= str[i] != '0';
+                exponent++;
+            }
+        }
+    }
+
+    if(i < length && str[i] == '.')
+    {
+        is_integer = JSCONE_FALSE;
+        i++;
+        if(i == length || !JSCONE_IS_DIGIT(str[i]))
+        {
+            return JSCONE_FAILURE;
+        }
+
+        for(; i < length && JSCONE_IS_DIGIT(str[i]); i++)
+        {
+            if(digits < JSCONE_MAX_MANTISSA_DIGITS)
+            {
+                mantissa = mantissa * 10 + (uint64_t)(str[i] - '0');
+                digits += mantissa != 0; // zeroes after the point are not significant until a digit is
+                exponent--;
+            }
+            else
+            {
+                truncated |= str[i] != '0';
+            }
+        }
+    }
+
+    if(i < length && (str[i] == 'e' || str[i] == 'E'))
+    {
+        is_integer = JSCONE_FALSE;
+        i++;
+        unsigned char negative_exponent = JSCONE_FALSE;
+        if(i < length && (str[i] == '+' || str[i] == '-'))
+        {
+            negative_exponent = str[i] == '-';
+            i++;
+        }
+
+        if(i == length || !JSCONE_IS_DIGIT(str[i]))
+        {
+            return JSCONE_FAILURE;
+        }
+
+        int exponent_value = 0;
+        for(; i < length && JSCONE_IS_DIGIT(str[i]); i++)
+        {
+            if(exponent_value < 100000) // way outside range of a double already
+            {
+                exponent_value = exponent_value * 10 + (str[i] - '0');
+            }
+        }
+        exponent += negative_exponent ? -exponent_value : exponent_value;
+    }
+
+    if(i != length)
+    {
+        return JSCONE_FAILURE;
+    }
+
+    *type = JSCONE_INT;
+    if(is_integer && exponent == 0 && mantissa > JSCONE_MAX_EXACT_INT) // exponent counts digits past the 19 read
+    {
+        /* keep the integer exactly if it fits */
+        if(!negative && mantissa <= (uint64_t)INT64_MAX)
+        {
+            value->integer = (int64_t)mantissa;
+            return JSCONE_SUCCESS;
+        }
+        else if(negative && mantissa <= (uint64_t)INT64_MAX + 1)
+        {
+            value->integer = mantissa == (uint64_t)INT64_MAX + 1 ? INT64_MIN : -(int64_t)mantissa;
+            return JSCONE_SUCCESS;
+        }
+    }
+
+    *type = JSCONE_NUM;
+    if(mantissa == 0 && !truncated)
+    {
+        value->num = negative ? -0.0 : 0.0;
+        return JSCONE_SUCCESS;
+    }
+
+    /* move powers of 10 into the mantissa while it stays exact, e.g. 12e25 = 12000e22 */
+    while(exponent > JSCONE_MAX_EXACT_POW10 && mantissa <= JSCONE_MAX_EXACT_INT / 10)
+    {
+        mantissa *= 10;
+        exponent--;
+    }
+
+    /*
+     * both mantissa and power of 10 are exact doubles so one multiply/divide rounds correctly,
+     * needs doubles not to be evaluated with extra precision (x87)
+     */
+    if(FLT_EVAL_METHOD == 0 && !truncated && mantissa <= JSCONE_MAX_EXACT_INT
+       && exponent >= -JSCONE_MAX_EXACT_POW10 && exponent <= JSCONE_MAX_EXACT_POW10)
+    {
+        value->num = (double)mantissa;
+        value->num = exponent < 0 ? value->num / powers_of_10[-exponent] : value->num * powers_of_10[exponent];
+        value->num = negative ? -value->num : value->num;
+        return JSCONE_SUCCESS;
+    }
+
+    /* rare, let libc round it */
+    value->num = jscone_strtod(str, length);
+    if(value->num == HUGE_VAL || value->num == -HUGE_VAL) // too big for a double
+    {
+        return JSCONE_FAILURE;
+    }
+
+    return JSCONE_SUCCESS;
+}
+
+double jscone_strtod(const char* str, size_t length)
+{
+    char buffer[JSCONE_STRTOD_BUFFER_SIZE];
+    if(length < JSCONE_NUM_BUFFER_SIZE)
+    {
+        memcpy(buffer, str, length);
+
+        /* strtod uses the locale's decimal point */
+        char* point = memchr(buffer, '.', length);
+        if(point != NULL)
+        {
+            *point = localeconv()->decimal_point[0];
+        }
+    }
+    else
+    {
+        length = jscone_number_shorten(buffer, str, length);
+    }
+    buffer[length] = '\0';
+
+    return strtod(buffer, NULL);
+}
+
+size_t jscone_number_shorten(char* buffer, const char* str, size_t length)
+{
+    /*
+     * writes a valid json number as <digits>e<exponent> with at most JSCONE_STRTOD_DIGITS digits,
+     * a halfway point between two doubles has fewer so the digits after only matter in whether any of them isn't 0
+     */
+    size_t i = 0;
+    size_t used = 0;
+    size_t digits = 0;
+    int64_t exponent = 0;
+    unsigned char fraction = JSCONE_FALSE;
+    unsigned char sticky = JSCONE_FALSE;
+
+    if(str[0] == '-')
+    {
+        buffer[used++] = '-';
+        i++;
+    }
+
+    for(; i < length && str[i] != 'e' && str[i] != 'E'; i++)
+    {
+        if(str[i] == '.')
+        {
+            fraction = JSCONE_TRUE;
+        }
+        else if(digits == 0 && str[i] == '0')
+        {
+            exponent -= fraction; // leading zeroes
+        }
+        else if(digits < JSCONE_STRTOD_DIGITS)
+        {
+            buffer[used++] = str[i];
+            digits++;
+            exponent -= fraction;
+        }
+        else
+        {
+            sticky |= str[i] != '0';
+            exponent += !fraction;
+        }
+    }
+
+    if(i < length)
+    {
+        i++;
+        unsigned char negative = str[i] == '-';
+        i += str[i] == '-' || str[i] == '+';
+
+        int64_t exponent_value = 0;
+        for(; i < length; i++)
+        {
+            if(exponent_value < 100000) // way outside range of a double already
+            {
+                exponent_value = exponent_value * 10 + (str[i] - '0');
+            }
+        }
+        exponent += negative ? -exponent_value : exponent_value;
+    }
+
+    if(digits == 0)
+    {
+        buffer[used++] = '0';
+    }
+    if(sticky)
+    {
+        buffer[used++] = '1';
+        exponent--;
+    }
+
+    /* 0 or infinity either way past this */
+    exponent = exponent < -100000 ? -100000 : exponent > 100000 ? 100000 : exponent;
+    used += (size_t)snprintf(buffer + used, JSCONE_STRTOD_BUFFER_SIZE - used, "e%d", (int)exponent);
+    return used;
+}
+
+int jscone_parser_parse_enum(JsconeParser* parser, const char* name)
+{
+    const char* token_start = parser->lexer.json + parser->lexer.curr.first;
+    size_t length = JSCONE_PARSER_TOKEN_LENGTH(parser);
+
+    if(length > 5 || length < 4)
+    {
+        JSCONE_PARSER_ERROR(parser, JSCONE_ERROR_LITERAL, "characters wrong size to be true/false/null enum");
+        return JSCONE_FAILURE;
+    }
+
+    JsconeType type;
+    JsconeVal value;
+    if(strncmp(token_start, "true", length) == 0)
+    {
+        type = JSCONE_BOOL;
+        value = (JsconeVal){.bool = JSCONE_TRUE};
+    }
+    else if(strncmp(token_start, "false", length) == 0)
+    {
+        type = JSCONE_BOOL;
+        value = (JsconeVal){.bool = JSCONE_FALSE};
+    }
+    else if(strncmp(token_start, "null", length) == 0)
+    {
+        type = JSCONE_NULL;
+        value = (JsconeVal){0};
+    }
+    else
+    {
+        JSCONE_PARSER_ERROR(parser, JSCONE_ERROR_LITERAL, "characters do not match true/false/null enums");
+        return JSCONE_FAILURE;
+    }
+
+    return jscone_parser_add_value(parser, type, value, name);
+}
+
+char* jscone_parser_get_string(JsconeParser* parser)
+{
+    size_t length = JSCONE_PARSER_TOKEN_LENGTH(parser) - 1; // since end is 1 past the last " and first is one past the first "
+
+    /* room for \0 and for the last character when there is no closing " (names in jscone_find) */
+    char* string = jscone_parser_alloc_string(parser, length + 2);
+    if(string == NULL)
+    {
+        return NULL;
+    }
+
+    char c;
+    size_t str_i = 0; 
+    unsigned char escaped = JSCONE_FALSE;
+    for(size_t i = 0; i < length + 1; i++) // assume starting after first " and include last " in loop
+    {
+        c = parser->lexer.json[parser->lexer.curr.first + i];
+        if(c == '\\')
+        {
+            if(escaped)
+            {
+                string[str_i++] = c;
+            }
+            escaped = !escaped;
+            continue;
+        }
+        else if(c == '\"')
+        {
+            if(!escaped)
+            {
+                break;
+            }
+            string[str_i++] = c;
+            escaped = !escaped;
+            continue;
+        }
+
+        /* handle escape sequence */
+        if(escaped)
+        {
+            char bytes[5];
+            unsigned char length = jscone_parse_escape_sequence(parser, i, bytes);
+            if(length == 0)
+            {
+                jscone_parser_free(parser, string);
+                return NULL;
+            }
+
+            for(unsigned char j = 0; j < length; j++)
+            {
+                string[str_i++] = bytes[j];
+            }
+
+            if(parser->lexer.json[parser->lexer.curr.first + i] == 'u') // skip 4 unicode hex characters
+            {
+                /* 4 bytes only come from a surrogate pair, so skip the second \uXXXX too */
+                i += length == 4 ? 10 : 4;
+            }
+            escaped = JSCONE_FALSE;
+            continue;
+        }
+        string[str_i++] = c;
+    }
+
+    string[str_i] = '\0';
+    jscone_parser_end_string(parser, string, str_i);
+
+    return string;
+}
+
+char* jscone_parser_alloc_string(JsconeParser* parser, size_t size)
+{
+    if(parser->tape != NULL)
+    {
+        /* reserve space at end of strings buffer, only used up in jscone_parser_end_string() */
+        JsconeTape* tape = parser->tape;
+        size_t needed = tape->strings_length + sizeof(size_t) + size;
+        if(needed > tape->strings_capacity)
+        {
+            size_t capacity = tape->strings_capacity * 2;
+            while(capacity < needed)
+            {
+                capacity *= 2;
+            }
+
+            char* strings = (char*)JSCONE_MEM_REALLOC(tape->strings, capacity);
+            if(strings == NULL)
+            {
+                return NULL;
+            }
+            tape->strings = strings;
+            tape->strings_capacity = capacity;
+        }
+
+        return tape->strings + tape->strings_length + sizeof(size_t);
+    }
+
+    if(parser->events != NULL)
+    {
+        /* reused for every string since callbacks are done with it before the next one */
+        JsconeEvents* events = parser->events;
+        if(size > events->capacity)
+        {
+            size_t capacity = events->capacity * 2;
+            while(capacity < size)
+            {
+                capacity *= 2;
+            }
+
+            char* buffer = (char*)JSCONE_MEM_REALLOC(events->buffer, capacity);
+            if(buffer == NULL)
+            {
+                return NULL;
+            }
+            events->buffer = buffer;
+            events->capacity = capacity;
+        }
+
+        return events->buffer;
+    }
+
+    if(parser->insitu != NULL)
+    {
+        /* decoded string is never longer than the source so it can overwrite it */
+        return parser->insitu + parser->lexer.curr.first;
+    }
+
+    if(parser->arena != NULL)
+    {
+        return (char*)jscone_arena_alloc(parser->arena, size, 1);
+    }
+
+    return (char*)JSCONE_MEM_STR_ALLOC(size);
+}
+
+void jscone_parser_end_string(JsconeParser* parser, char* string, size_t length)
+{
+    if(parser->tape != NULL)
+    {
+        memcpy(string - sizeof(size_t), &length, sizeof(size_t));
+        parser->tape->strings_length += sizeof(size_t) + length + 1;
+    }
+    else if(parser->events != NULL)
+    {
+        parser->events->length = length;
+    }
+    else if(parser->arena != NULL && parser->insitu == NULL)
+    {
+        /* string was the last allocation so give back what the escapes didn't use */
+        JsconeArenaBlock* block = parser->arena->head;
+        block->used = (size_t)(string - (char*)(block + 1)) + length + 1;
+    }
+}
+
+int jscone_parser_begin_node(JsconeParser* parser, JsconeType type, const char* name)
+{
+    if(parser->tape != NULL)
+    {
+        JsconeTape* tape = parser->tape;
+        unsigned char tag = type == JSCONE_OBJECT ? JSCONE_TAPE_OBJECT_START : JSCONE_TAPE_ARRAY_START;
+
+        /* payload holds the container this one is inside until it ends */
+        size_t outer = tape->open;
+        tape->open = tape->length + 1;
+        return jscone_tape_push(tape, tag, outer);
+    }
+
+    if(parser->events != NULL)
+    {
+        JsconeEvents* events = parser->events;
+        return type == JSCONE_OBJECT ? JSCONE_EVENT(events, start_object, events->user) : JSCONE_EVENT(events, start_array, events->user);
+    }
+
+    parser->curr_node = jscone_parser_create_node(parser, type, (JsconeVal){0}, name);
+    return parser->curr_node == NULL ? JSCONE_FAILURE : JSCONE_SUCCESS;
+}
+
+int jscone_parser_end_node(JsconeParser* parser, JsconeType type)
+{
+    if(parser->tape != NULL)
+    {
+        /* point start and end of container at each other */
+        JsconeTape* tape = parser->tape;
+        size_t start = tape->open - 1;
+        unsigned char tag = JSCONE_TAPE_TAG(tape->entries[start]);
+        unsigned char end_tag = (tag & ~JSCONE_TAPE_KEYED) == JSCONE_TAPE_OBJECT_START ? JSCONE_TAPE_OBJECT_END : JSCONE_TAPE_ARRAY_END;
+
+        tape->open = JSCONE_TAPE_PAYLOAD(tape->entries[start]);
+        tape->entries[start] = JSCONE_TAPE_ENTRY(tag, tape->length);
+
+        /* containers can end one after another, so the entry reserved by the last push isn't always free */
+        return jscone_tape_push(tape, end_tag, start);
+    }
+
+    if(parser->events != NULL)
+    {
+        JsconeEvents* events = parser->events;
+        return type == JSCONE_OBJECT ? JSCONE_EVENT(events, end_object, events->user) : JSCONE_EVENT(events, end_array, events->user);
+    }
+
+    if(type == JSCONE_OBJECT && (parser->flags & JSCONE_HASH_MEMBERS) && parser->curr_node->count >= JSCONE_HASH_MIN_MEMBERS
+    && jscone_members_build(parser->curr_node, parser->arena) == JSCONE_FAILURE)
+    {
+        return JSCONE_FAILURE;
+    }
+    if(type == JSCONE_ARRAY && jscone_elements_build(parser->curr_node, parser->arena) == JSCONE_FAILURE)
+    {
+        return JSCONE_FAILURE;
+    }
+
+    /* go back up the tree so next calls work, root node stays */
+    if(parser->curr_node->parent != NULL)
+    {
+        parser->curr_node = parser->curr_node->parent;
+    }
+    return JSCONE_SUCCESS;
+}
+
+int jscone_parser_add_value(JsconeParser* parser, JsconeType type, JsconeVal value, const char* name)
+{
+    if(parser->tape != NULL)
+    {
+        JsconeTape* tape = parser->tape;
+        switch(type)
+        {
+            case JSCONE_STRING:
+                return jscone_tape_push(tape, JSCONE_TAPE_STRING, (size_t)(value.str - tape->strings) - sizeof(size_t));
+            case JSCONE_NUM: case JSCONE_INT:
+            {
+                uint64_t bits;
+                memcpy(&bits, &value, sizeof(uint64_t)); // num and integer are both 64 bits
+                if(jscone_tape_push(tape, type == JSCONE_INT ? JSCONE_TAPE_INT : JSCONE_TAPE_NUM, 0) == JSCONE_FAILURE)
+                {
+                    return JSCONE_FAILURE;
+                }
+                tape->entries[tape->length++] = bits; // jscone_tape_push() reserves an extra entry
+                return JSCONE_SUCCESS;
+            }
+            case JSCONE_BOOL:
+                return jscone_tape_push(tape, value.bool ? JSCONE_TAPE_TRUE : JSCONE_TAPE_FALSE, 0);
+            default:
+                return jscone_tape_push(tape, JSCONE_TAPE_NULL, 0);
+        }
+    }
+
+    if(parser->events != NULL)
+    {
+        JsconeEvents* events = parser->events;
+        switch(type)
+        {
+            case JSCONE_STRING:
+                return JSCONE_EVENT(events, string, events->user, value.str, events->length);
+            case JSCONE_NUM:
+                return JSCONE_EVENT(events, number, events->user, value.num);
+            case JSCONE_INT:
+                if(events->handler->integer == NULL)
+                {
+                    return JSCONE_EVENT(events, number, events->user, (double)value.integer);
+                }
+                return events->handler->integer(events->user, value.integer);
+            case JSCONE_BOOL:
+                return JSCONE_EVENT(events, boolean, events->user, value.bool);
+            default:
+                return JSCONE_EVENT(events, null, events->user);
+        }
+    }
+
+    return jscone_parser_create_node(parser, type, value, name) == NULL ? JSCONE_FAILURE : JSCONE_SUCCESS;
+}
+
+JsconeNode* jscone_parser_create_node(JsconeParser* parser, JsconeType type, JsconeVal value, const char* name)
+{
+    JsconeNode* node;
+    if(parser->arena != NULL)
+    {
+        node = (JsconeNode*)jscone_arena_alloc(parser->arena, sizeof(JsconeNode), JSCONE_ARENA_ALIGN);
+    }
+    else
+    {
+        node = jscone_node_alloc(parser->curr_node);
+    }
+
+    if(node == NULL)
+    {
+        return NULL;
+    }
+
+    jscone_node_init(node, parser->curr_node, type, value);
+    node->name = name;
+    if(parser->arena != NULL)
+    {
+        node->flags |= JSCONE_NODE_ARENA;
+    }
+    else if(parser->curr_node == NULL)
+    {
+        node->flags |= JSCONE_NODE_TREE;
+    }
+    if(parser->symbols != NULL && name != NULL)
+    {
+        node->flags |= JSCONE_NODE_INTERNED;
+    }
+
+    return node;
+}
+
+void jscone_parser_free(JsconeParser* parser, void* ptr)
+{
+    /* arena and tape memory is only freed all at once, events reuse one buffer */
+    if(parser->arena == NULL && parser->tape == NULL && parser->events == NULL)
+    {
+        JSCONE_MEM_FREE(ptr);
+    }
+}
+
+
+
+/* lexing */
+
+int jscone_lexer_next_token(JsconeLexer* lexer)
+{
+    if(lexer->index != NULL)
+    {
+        return jscone_lexer_next_indexed_token(lexer);
+    }
+
+    lexer->curr.first = lexer->curr.end;
+
+    /* skip whitespace */
+    while(JSCONE_TRUE)
+    {
+        if(lexer->curr.first >= lexer->length)
+        {
+            lexer->curr.first = lexer->length;
+            lexer->curr.end = lexer->curr.first;
+            return JSCONE_SUCCESS;
+        }
+
+        switch(lexer->json[lexer->curr.first])
+        {
+            case '\0': // if length is incorrect
+                lexer->length = lexer->curr.first;
+                lexer->curr.end = lexer->curr.first;
+                return JSCONE_SUCCESS;
+
+            case '\r': case '\t': case ' ': case '\n':
+                lexer->curr.first++;
+                break;
+
+            default:
+                goto begin_lexing;
+        }
+    }
+
+    begin_lexing:
+
+    lexer->curr.end = lexer->curr.first;
+
+    while(JSCONE_TRUE)
+    {
+        if(lexer->curr.end > lexer->length - 1) // can be one past end (on \0)
+        {
+            return JSCONE_SUCCESS;
+        }
+
+        switch(lexer->json[lexer->curr.end])
+        {
+            case '\0':
+                return JSCONE_SUCCESS;
+
+            case '{': case '}':
+            case '[': case ']':
+            case ':': case ',':
+                /* only if not coming from contiguous characters */
+                if(lexer->curr.first == lexer->curr.end)
+                {
+                    lexer->curr.end++;
+                }
+
+                return JSCONE_SUCCESS;
+
+            case '\"':
+                /* check if coming from contiguous characters */
+                if(lexer->curr.first < lexer->curr.end)
+                {
+                    JSCONE_LEXER_ERROR(lexer, JSCONE_ERROR_SYNTAX, "unexpected char \"");
+                    return JSCONE_FAILURE;
+                }
+
+                return jscone_lexer_lex_string(lexer);
+
+            case '\r': case '\t': case ' ': case '\n':
+                /* have reached end of contiguous characters  */
+                return JSCONE_SUCCESS;
+
+            default:
+                /* contiguous characters (could be a number, true/false, null or invalid token) */
+                lexer->curr.end++;
+                break;
+        }
+    }
+
+    return JSCONE_SUCCESS;
+}
+
+int jscone_lexer_lex_string(JsconeLexer* lexer)
+{
+    unsigned char escaped = JSCONE_FALSE;
+
+    /* skip first " */
+    lexer->curr.end++;
+
+    while(JSCONE_TRUE)
+    {
+        if(lexer->curr.end > lexer->length - 1) // one past end
+        {
+            JSCONE_LEXER_ERROR(lexer, JSCONE_ERROR_STRING, "expected char \" before end of file");
+            return JSCONE_FAILURE; // reached EOF before end of string
+        }
+
+        switch(lexer->json[lexer->curr.end])
+        {
+            case '\0':
+                JSCONE_LEXER_ERROR(lexer, JSCONE_ERROR_STRING, "expected char \" before end of file");
+                return JSCONE_FAILURE; // reached EOF before end of string
+
+            case '\\':
+                /* toggle escaped incase it is escaping a backslash */
+                escaped = !escaped;
+                lexer->curr.end++;
+                break;
+
+            case '\"':
+                lexer->curr.end++;
+
+                /* only end string if quote is not escaped */
+                if(!escaped)
+                {
+                    return JSCONE_SUCCESS;
+                }
+
+                escaped = JSCONE_FALSE;
+                break;
+
+            default:
+                if((unsigned char)lexer->json[lexer->curr.end] < 0x20)
+                {
+                    JSCONE_LEXER_ERROR(lexer, JSCONE_ERROR_STRING, "invalid control character in string (newline, tab)");
+                    return JSCONE_FAILURE;
+                }
+
+                /* characters of string */
+                lexer->curr.end++;
+                escaped = JSCONE_FALSE;
+                break;
+        }
+    }
+}
+
+int jscone_lexer_next_indexed_token(JsconeLexer* lexer)
+{
+    JsconeIndex* index = lexer->index;
+
+    if(index->pos >= index->count && jscone_index_fill(lexer) == JSCONE_FAILURE)
+    {
+        return JSCONE_FAILURE;
+    }
+
+    /* EOF */
+    if(index->pos >= index->count)
+    {
+        lexer->curr.first = lexer->length;
+        lexer->curr.end = lexer->length;
+        return JSCONE_SUCCESS;
+    }
+
+    size_t first = index->positions[index->pos++];
+    lexer->curr.first = first;
+
+    switch(lexer->json[first])
+    {
+        case '{': case '}':
+        case '[': case ']':
+        case ':': case ',':
+            lexer->curr.end = first + 1;
+            return JSCONE_SUCCESS;
+
+        case '\"':
+            /* closing quote is the next position */
+            if(index->pos >= index->count && jscone_index_fill(lexer) == JSCONE_FAILURE)
+            {
+                return JSCONE_FAILURE;
+            }
+            if(index->pos >= index->count)
+            {
+                lexer->curr.end = lexer->length;
+                JSCONE_LEXER_ERROR(lexer, JSCONE_ERROR_STRING, "expected char \" before end of file");
+                return JSCONE_FAILURE;
+            }
+
+            lexer->curr.end = index->positions[index->pos++] + 1;
+            return JSCONE_SUCCESS;
+
+        default:
+            /* contiguous characters (could be a number, true/false, null or invalid token) */
+            lexer->curr.end = first + 1;
+            while(lexer->curr.end < lexer->length)
+            {
+                switch(lexer->json[lexer->curr.end])
+                {
+                    case '{': case '}':
+                    case '[': case ']':
+                    case ':': case ',': case '\0':
+                    case '\r': case '\n': case '\t': case ' ':
+                        return JSCONE_SUCCESS;
+                    case '\"':
+                        JSCONE_LEXER_ERROR(lexer, JSCONE_ERROR_SYNTAX, "unexpected char \"");
+                        return JSCONE_FAILURE;
+                    default:
+                        lexer->curr.end++;
+                        break;
+                }
+            }
+            return JSCONE_SUCCESS;
+    }
+}
+
+
+
+
+/* errors */
+
+int jscone_error_set(JsconeErrorCode code, size_t offset, const char* message)
+{
+    jscone_error = (JsconeError){.code = code, .byte_offset = offset, .message = message};
+    if(jscone_log != NULL)
+    {
+        jscone_log(jscone_log_user, &jscone_error);
+    }
+    return JSCONE_FAILURE;
+}
+
+
+
+/* files */
+
+char* jscone_file_open(const char* path, size_t* size)
+{
+#ifdef JSCONE_MMAP
+    int fd = open(path, O_RDONLY);
+    if(fd < 0)
+    {
+        JSCONE_ERROR(JSCONE_ERROR_FILE, "could not open file");
+        return NULL;
+    }
+
+    struct stat info;
+    if(fstat(fd, &info) != 0 || info.st_size <= 0)
+    {
+        JSCONE_ERROR(JSCONE_ERROR_FILE, "could not get size of file or it is empty");
+        close(fd);
+        return NULL;
+    }
+    *size = (size_t)info.st_size;
+
+    void* map = mmap(NULL, *size, PROT_READ, MAP_PRIVATE, fd, 0);
+    close(fd); // mapping keeps the file open
+    if(map == MAP_FAILED)
+    {
+        JSCONE_ERROR(JSCONE_ERROR_FILE, "could not map file");
+        return NULL;
+    }
+
+    /* only hidden by strict -std=c99, it is just a hint */
+#if defined(MADV_SEQUENTIAL)
+    madvise(map, *size, MADV_SEQUENTIAL);
+#elif defined(POSIX_MADV_SEQUENTIAL)
+    posix_madvise(map, *size, POSIX_MADV_SEQUENTIAL);
+#endif
+
+    return (char*)map;
+#else
+    FILE* file = fopen(path, "rb");
+    if(file == NULL)
+    {
+        JSCONE_ERROR(JSCONE_ERROR_FILE, "could not open file");
+        return NULL;
+    }
+
+    long file_size = -1;
+    if(fseek(file, 0, SEEK_END) == 0)
+    {
+        file_size = ftell(file);
+    }
+    if(file_size <= 0 || fseek(file, 0, SEEK_SET) != 0)
+    {
+        JSCONE_ERROR(JSCONE_ERROR_FILE, "could not get size of file or it is empty");
+        fclose(file);
+        return NULL;
+    }
+    *size = (size_t)file_size;
+
+    char* json = (char*)JSCONE_MEM_ALLOC(*size);
+    if(json == NULL || fread(json, 1, *size, file) != *size)
+    {
+        JSCONE_ERROR(JSCONE_ERROR_FILE, "could not read file");
+        JSCONE_MEM_FREE(json);
+        fclose(file);
+        return NULL;
+    }
+
+    fclose(file);
+    return json;
+#endif
+}
+
+void jscone_file_close(char* json, size_t size, const JsconeAllocator* allocator)
+{
+#ifdef JSCONE_MMAP
+    (void)allocator;
+    munmap(json, size);
+#else
+    (void)size;
+    allocator->free(allocator->ctx, json);
+#endif
+}
+
+
+
+/* many documents */
+
+unsigned int jscone_many_threads(unsigned int threads)
+{
+#ifdef JSCONE_THREADS
+    if(threads == 0)
+    {
+        long cpus = sysconf(_SC_NPROCESSORS_ONLN);
+        threads = cpus > 0 ? (unsigned int)cpus : 1;
+    }
+#else
+    threads = 1;
+#endif
+    return threads > JSCONE_MANY_MAX_THREADS ? JSCONE_MANY_MAX_THREADS : threads;
+}
+
+int jscone_many_start(JsconeMany* many, const char* json, size_t capacity, unsigned int threads)
+{
+    threads = jscone_many_threads(threads);
+    capacity = capacity < threads ? threads : capacity;
+
+    *many = (JsconeMany){
+        .json = json,
+        .docs = (JsconeToken*)JSCONE_MEM_ALLOC(capacity * sizeof(JsconeToken)),
+        .roots = (JsconeNode**)JSCONE_MEM_ALLOC(capacity * sizeof(JsconeNode*)),
+        .count = 0,
+        .capacity = capacity,
+        .range_type = JSCONE_NULL,
+        .flags = 0,
+        .max_depth = 0,
+        .allocator = jscone_allocator,
+        .workers = (JsconeWorker*)JSCONE_MEM_ALLOC(threads * sizeof(JsconeWorker)),
+        .worker_count = 0,
+    };
+
+    if(many->docs == NULL || many->roots == NULL || many->workers == NULL)
+    {
+        jscone_many_stop(many);
+        return JSCONE_FAILURE;
+    }
+
+    for(; many->worker_count < threads; many->worker_count++)
+    {
+        JsconeWorker* worker = &many->workers[many->worker_count];
+        worker->many = many;
+        if(jscone_arena_init(&worker->arena, JSCONE_MANY_BATCH_SIZE) == JSCONE_FAILURE)
+        {
+            jscone_many_stop(many);
+            return JSCONE_FAILURE;
+        }
+    }
+
+#ifdef JSCONE_THREADS
+    pthread_mutex_init(&many->mutex, NULL);
+    pthread_cond_init(&many->start, NULL);
+    pthread_cond_init(&many->done, NULL);
+    many->batch = 0;
+    many->pending = 0;
+    many->quit = JSCONE_FALSE;
+    many->started = JSCONE_TRUE;
+
+    /* first worker is this thread */
+    unsigned int started = 1;
+    for(; started < many->worker_count; started++)
+    {
+        if(pthread_create(&many->workers[started].thread, NULL, jscone_worker_main, &many->workers[started]) != 0)
+        {
+            break;
+        }
+    }
+
+    /* arenas of threads that didn't start aren't used */
+    for(unsigned int i = started; i < many->worker_count; i++)
+    {
+        jscone_arena_free(&many->workers[i].arena);
+    }
+    many->worker_count = started;
+#endif
+
+    return JSCONE_SUCCESS;
+}
+
+void jscone_many_stop(JsconeMany* many)
+{
+#ifdef JSCONE_THREADS
+    if(many->started)
+    {
+        pthread_mutex_lock(&many->mutex);
+        many->quit = JSCONE_TRUE;
+        pthread_cond_broadcast(&many->start);
+        pthread_mutex_unlock(&many->mutex);
+        for(unsigned int i = 1; i < many->worker_count; i++)
+        {
+            pthread_join(many->workers[i].thread, NULL);
+        }
+
+        pthread_mutex_destroy(&many->mutex);
+        pthread_cond_destroy(&many->start);
+        pthread_cond_destroy(&many->done);
+    }
+#endif
+
+    for(unsigned int i = 0; i < many->worker_count; i++)
+    {
+        jscone_arena_free(&many->workers[i].arena);
+    }
+    JSCONE_MEM_FREE(many->docs);
+    JSCONE_MEM_FREE(many->roots);
+    JSCONE_MEM_FREE(many->workers);
+}
+
+int jscone_many_next(const char* json, size_t length, size_t* position, JsconeToken* doc)
+{
+    size_t i = *position;
+    while(i < length && JSCONE_IS_WHITESPACE(json[i]))
+    {
+        i++;
+    }
+    if(i >= length || json[i] == '\0')
+    {
+        return JSCONE_FAILURE;
+    }
+
+    /* find matching bracket, the parser will find any errors */
+    doc->first = i;
+    size_t depth = 0;
+    unsigned char in_string = JSCONE_FALSE;
+    for(; i < length && json[i] != '\0'; i++)
+    {
+        char c = json[i];
+        if(in_string)
+        {
+            if(c == '\\')
+            {
+                i++;
+            }
+            else if(c == '\"')
+            {
+                in_string = JSCONE_FALSE;
+            }
+            continue;
+        }
+
+        if(c == '\"')
+        {
+            in_string = JSCONE_TRUE;
+        }
+        else if(c == '{' || c == '[')
+        {
+            depth++;
+        }
+        else if((c == '}' || c == ']') && depth > 0 && --depth == 0)
+        {
+            i++;
+            break;
+        }
+        else if(depth == 0) // not an object/array, give the rest to the parser to error on
+        {
+            i = length;
+            break;
+        }
+    }
+
+    doc->end = i < length ? i : length;
+    *position = doc->end;
+    return JSCONE_SUCCESS;
+}
+
+size_t jscone_parallel_split(const char* json, size_t length, JsconeToken* ranges, size_t count, JsconeType* type)
+{
+    size_t i = 0;
+    while(i < length && JSCONE_IS_WHITESPACE(json[i]))
+    {
+        i++;
+    }
+    if(i == length || (json[i] != '{' && json[i] != '['))
+    {
+        jscone_error_set(JSCONE_ERROR_SYNTAX, i, "first character not { or [");
+        return 0;
+    }
+    *type = json[i] == '{' ? JSCONE_OBJECT : JSCONE_ARRAY;
+
+    /* cut at top-level commas once a range is big enough */
+    size_t target = length / count;
+    size_t range = 0;
+    ranges[0].first = ++i;
+
+    size_t depth = 1;
+    unsigned char in_string = JSCONE_FALSE;
+    for(; i < length && json[i] != '\0'; i++)
+    {
+        char c = json[i];
+        if(in_string)
+        {
+            if(c == '\\')
+            {
+                i++;
+            }
+            else if(c == '\"')
+            {
+                in_string = JSCONE_FALSE;
+            }
+        }
+        else if(c == '\"')
+        {
+            in_string = JSCONE_TRUE;
+        }
+        else if(c == '{' || c == '[')
+        {
+            depth++;
+        }
+        else if((c == '}' || c == ']') && --depth == 0)
+        {
+            break;
+        }
+        else if(c == ',' && depth == 1 && i - ranges[range].first >= target && range + 1 < count)
+        {
+            ranges[range].end = i;
+            ranges[++range].first = i + 1;
+        }
+    }
+
+    if(i >= length || json[i] == '\0')
+    {
+        jscone_error_set(JSCONE_ERROR_SYNTAX, i, "missing closing bracket for root");
+        return 0;
+    }
+    if(json[i] != (*type == JSCONE_OBJECT ? '}' : ']'))
+    {
+        jscone_error_set(JSCONE_ERROR_SYNTAX, i, "root closing bracket does not match opening one");
+        return 0;
+    }
+    ranges[range].end = i;
+
+    /* a range with nothing in it came from a comma with no value next to it */
+    for(size_t r = 0; range > 0 && r <= range; r++)
+    {
+        size_t k = ranges[r].first;
+        while(k < ranges[r].end && JSCONE_IS_WHITESPACE(json[k]))
+        {
+            k++;
+        }
+        if(k == ranges[r].end)
+        {
+            jscone_error_set(JSCONE_ERROR_SYNTAX, k, "missing value next to comma");
+            return 0;
+        }
+    }
+
+    /* only whitespace is allowed after json end */
+    for(i++; i < length && json[i] != '\0'; i++)
+    {
+        if(!JSCONE_IS_WHITESPACE(json[i]))
+        {
+            jscone_error_set(JSCONE_ERROR_SYNTAX, i, "extra characters after JSON end");
+            return 0;
+        }
+    }
+
+    return range + 1;
+}
+
+void jscone_many_run(JsconeMany* many)
+{
+    /* split by bytes so each thread has about the same work */
+    size_t total = 0;
+    for(size_t i = 0; i < many->count; i++)
+    {
+        total += many->docs[i].end - many->docs[i].first;
+    }
+
+    size_t doc = 0;
+    size_t bytes = 0;
+    for(unsigned int w = 0; w < many->worker_count; w++)
+    {
+        size_t target = total / many->worker_count * (w + 1);
+        many->workers[w].first = doc;
+        while(doc < many->count && (bytes < target || w + 1 == many->worker_count))
+        {
+            bytes += many->docs[doc].end - many->docs[doc].first;
+            doc++;
+        }
+        many->workers[w].end = doc;
+    }
+
+#ifdef JSCONE_THREADS
+    pthread_mutex_lock(&many->mutex);
+    many->batch++;
+    many->pending = many->worker_count - 1;
+    pthread_cond_broadcast(&many->start);
+    pthread_mutex_unlock(&many->mutex);
+#endif
+
+    jscone_worker_parse(&many->workers[0]);
+
+#ifdef JSCONE_THREADS
+    pthread_mutex_lock(&many->mutex);
+    while(many->pending > 0)
+    {
+        pthread_cond_wait(&many->done, &many->mutex);
+    }
+    pthread_mutex_unlock(&many->mutex);
+#endif
+}
+
+void jscone_worker_parse(JsconeWorker* worker)
+{
+    JsconeMany* many = worker->many;
+    jscone_arena_reset(&worker->arena);
+    worker->error.code = JSCONE_ERROR_NONE;
+
+    for(size_t i = worker->first; i < worker->end; i++)
+    {
+        JsconeParser parser = {
+            .lexer = {
+                .json = many->json + many->docs[i].first,
+                .length = many->docs[i].end - many->docs[i].first,
+                .curr = {.first = 0, .end = 0},
+                .base = many->docs[i].first,
+            },
+            .curr_node = NULL,
+            .arena = &worker->arena,
+            .flags = many->flags,
+            .max_depth = many->max_depth,
+        };
+
+        if(many->range_type == JSCONE_NULL)
+        {
+            many->roots[i] = jscone_parser_parse_root(&parser) == JSCONE_FAILURE ? NULL : parser.curr_node;
+        }
+        else
+        {
+            /* stand-in parent, its children are moved to the real root after */
+            JsconeNode* range = jscone_parser_create_node(&parser, many->range_type, (JsconeVal){0}, NULL);
+            parser.curr_node = range;
+            if(range == NULL)
+            {
+                JSCONE_ERROR(JSCONE_ERROR_MEMORY, "out of memory");
+            }
+            many->roots[i] = range == NULL || jscone_parser_parse_range(&parser, many->range_type) == JSCONE_FAILURE ? NULL : range;
+        }
+
+        /* documents are given in order so only the first failure is ever needed */
+        if(many->roots[i] == NULL && worker->error.code == JSCONE_ERROR_NONE)
+        {
+            worker->error = jscone_error;
+        }
+    }
+}
+
+void jscone_many_error(const JsconeMany* many, size_t doc)
+{
+    /* error was recorded on the worker's thread */
+    for(unsigned int w = 0; w < many->worker_count; w++)
+    {
+        if(doc >= many->workers[w].first && doc < many->workers[w].end)
+        {
+            jscone_error = many->workers[w].error;
+            return;
+        }
+    }
+}
+
+#ifdef JSCONE_THREADS
+void* jscone_worker_main(void* arg)
+{
+    JsconeWorker* worker = (JsconeWorker*)arg;
+    JsconeMany* many = worker->many;
+    unsigned int batch = 0;
+    jscone_allocator = many->allocator;
+
+    while(JSCONE_TRUE)
+    {
+        pthread_mutex_lock(&many->mutex);
+        while(many->batch == batch && !many->quit)
+        {
+            pthread_cond_wait(&many->start, &many->mutex);
+        }
+        if(many->quit)
+        {
+            pthread_mutex_unlock(&many->mutex);
+            return NULL;
+        }
+        batch = many->batch;
+        pthread_mutex_unlock(&many->mutex);
+
+        jscone_worker_parse(worker);
+
+        pthread_mutex_lock(&many->mutex);
+        if(--many->pending == 0)
+        {
+            pthread_cond_signal(&many->done);
+        }
+        pthread_mutex_unlock(&many->mutex);
+    }
+}
+#endif
+
+
+
+/* streaming */
+
+int jscone_stream_token(JsconeStream* stream, const char* token, size_t length)
+{
+    /* point lexer at token so the parser functions can read it */
+    JsconeLexer* lexer = &stream->parser.lexer;
+    lexer->json = token;
+    lexer->length = length;
+    lexer->curr.first = 0;
+    lexer->curr.end = length;
+    lexer->base = stream->token_offset;
+
+    switch(stream->state)
+    {
+        case JSCONE_STREAM_ROOT:
+            if(token[0] == '{' || token[0] == '[')
+            {
+                return jscone_stream_begin(stream, token[0] == '{' ? JSCONE_OBJECT : JSCONE_ARRAY);
+            }
+            JSCONE_STREAM_ERROR(stream, JSCONE_ERROR_SYNTAX, "first character not { or [");
+            return JSCONE_FAILURE;
+
+        case JSCONE_STREAM_FIRST_VALUE:
+            if(token[0] == ']')
+            {
+                return jscone_stream_end(stream, ']');
+            }
+            return jscone_stream_value(stream, token);
+        case JSCONE_STREAM_VALUE:
+            return jscone_stream_value(stream, token);
+
+        case JSCONE_STREAM_FIRST_KEY:
+            if(token[0] == '}')
+            {
+                return jscone_stream_end(stream, '}');
+            }
+            /* fall through */
+        case JSCONE_STREAM_KEY:
+            if(token[0] != '\"')
+            {
+                JSCONE_STREAM_ERROR(stream, JSCONE_ERROR_SYNTAX, "object name string is missing first quote");
+                return JSCONE_FAILURE;
+            }
+            stream->key = jscone_parser_parse_name(&stream->parser);
+            if(stream->key == NULL)
+            {
+                return JSCONE_FAILURE;
+            }
+            stream->state = JSCONE_STREAM_COLON;
+            return JSCONE_SUCCESS;
+
+        case JSCONE_STREAM_COLON:
+            if(token[0] != ':')
+            {
+                JSCONE_STREAM_ERROR(stream, JSCONE_ERROR_SYNTAX, "expected char :");
+                return JSCONE_FAILURE;
+            }
+            stream->state = JSCONE_STREAM_VALUE;
+            return JSCONE_SUCCESS;
+
+        case JSCONE_STREAM_COMMA:
+            if(token[0] == ',')
+            {
+                stream->state = stream->levels[stream->depth - 1].type == JSCONE_OBJECT ? JSCONE_STREAM_KEY : JSCONE_STREAM_VALUE;
+                return JSCONE_SUCCESS;
+            }
+            if(token[0] == '}' || token[0] == ']')
+            {
+                return jscone_stream_end(stream, token[0]);
+            }
+            JSCONE_STREAM_ERROR(stream, JSCONE_ERROR_SYNTAX, "missing comma or closing brace");
+            return JSCONE_FAILURE;
+
+        default:
+            JSCONE_STREAM_ERROR(stream, JSCONE_ERROR_SYNTAX, "extra characters after JSON end");
+            return JSCONE_FAILURE;
+    }
+}
+
+int jscone_stream_value(JsconeStream* stream, const char* token)
+{
+    JsconeLevel* level = &stream->levels[stream->depth - 1];
+    const char* name = level->type == JSCONE_OBJECT ? stream->key : level->name;
 
-    char c;
-    unsigned char escaped = JSCONE_FALSE;
-    for(unsigned int i = 0;; i++)
+    int ret;
+    switch(token[0])
+    {
+        case '{':
+            return jscone_stream_begin(stream, JSCONE_OBJECT);
+        case '[':
+            return jscone_stream_begin(stream, JSCONE_ARRAY);
+        case '}': case ']':
+        case ':': case ',':
+            JSCONE_STREAM_ERROR(stream, JSCONE_ERROR_SYNTAX, "expected value");
+            return JSCONE_FAILURE;
+        case '\"':
+            ret = jscone_parser_parse_string(&stream->parser, name);
+            break;
+        case '0': case '1': case '2': case '3': case '4':
+        case '5': case '6': case '7': case '8': case '9':
+        case '-': case '.':
+            ret = jscone_parser_parse_number(&stream->parser, name);
+            break;
+        default:
+            ret = jscone_parser_parse_enum(&stream->parser, name);
+            break;
+    }
+
+    if(ret == JSCONE_SUCCESS)
     {
-        c = path[i];
+        stream->key = NULL; // now owned by the node
+        stream->state = JSCONE_STREAM_COMMA;
+    }
+    return ret;
+}
 
-        switch(c)
+int jscone_stream_begin(JsconeStream* stream, JsconeType type)
+{
+    const char* name = NULL;
+    if(stream->depth > 0)
+    {
+        JsconeLevel* level = &stream->levels[stream->depth - 1];
+        name = level->type == JSCONE_OBJECT ? stream->key : level->name;
+    }
+
+    if(stream->depth == stream->capacity)
+    {
+        JsconeLevel* levels = (JsconeLevel*)JSCONE_MEM_REALLOC(stream->levels, stream->capacity * 2 * sizeof(JsconeLevel));
+        if(levels == NULL)
         {
-            case '\\':
-                escaped = !escaped;
-                break;
-            case '/': case '\0':
-                if(escaped)
-                {
-                    parser.lexer.curr.end++;
-                    escaped = JSCONE_FALSE;
-                    continue;
-                }
+            return JSCONE_FAILURE;
+        }
+        stream->levels = levels;
+        stream->capacity *= 2;
+    }
+
+    if(jscone_parser_begin_node(&stream->parser, type, name) == JSCONE_FAILURE)
+    {
+        return JSCONE_FAILURE;
+    }
+    if(stream->root == NULL && stream->parser.events == NULL)
+    {
+        stream->root = stream->parser.curr_node;
+    }
 
-                /* we have a full name */
+    stream->key = NULL;
+    stream->levels[stream->depth++] = (JsconeLevel){.type = type, .name = name};
+    stream->state = type == JSCONE_OBJECT ? JSCONE_STREAM_FIRST_KEY : JSCONE_STREAM_FIRST_VALUE;
+    return JSCONE_SUCCESS;
+}
 
-                curr_name = jscone_parser_get_string(&parser);
-                if(jscone_find_name_in_siblings(&parser, curr_name) == NULL)
-                {
-                    free(curr_name);
-                    return NULL;
-                }
-                free(curr_name);
+int jscone_stream_end(JsconeStream* stream, char close)
+{
+    JsconeType type = stream->levels[stream->depth - 1].type;
+    if(close != (type == JSCONE_OBJECT ? '}' : ']'))
+    {
+        JSCONE_STREAM_ERROR(stream, JSCONE_ERROR_SYNTAX, "closing bracket does not match");
+        return JSCONE_FAILURE;
+    }
 
-                parser.lexer.curr.first = parser.lexer.curr.end + 1; // move ahead of /
+    stream->depth--;
+    stream->state = stream->depth == 0 ? JSCONE_STREAM_END : JSCONE_STREAM_COMMA;
+    return jscone_parser_end_node(&stream->parser, type);
+}
 
-                if(c == '\0') // bit scuffed
-                {
-                    return parser.curr_node;
-                }
-                else if(parser.curr_node->child == NULL)
-                {
-                    JSCONE_ERROR("reached terminating node before it was expected\n");
-                    return NULL;
-                }
-                parser.curr_node = parser.curr_node->child;
+int jscone_stream_append(JsconeStream* stream, const char* chunk, size_t length)
+{
+    size_t needed = stream->token_length + length;
+    if(needed > stream->token_capacity)
+    {
+        size_t capacity = stream->token_capacity * 2;
+        while(capacity < needed)
+        {
+            capacity *= 2;
+        }
+
+        char* token = (char*)JSCONE_MEM_REALLOC(stream->token, capacity);
+        if(token == NULL)
+        {
+            return JSCONE_FAILURE;
+        }
+        stream->token = token;
+        stream->token_capacity = capacity;
+    }
 
+    memcpy(stream->token + stream->token_length, chunk, length);
+    stream->token_length += length;
+    return JSCONE_SUCCESS;
+}
+
+
+
+/* on-demand cursor */
+
+JsconeLexer jscone_cursor_lexer(const JsconeCursor* cursor)
+{
+    return (JsconeLexer){
+        .json = cursor->json,
+        .length = cursor->length,
+        .curr = {.first = cursor->first, .end = cursor->end},
+        .index = NULL,
+    };
+}
+
+int jscone_cursor_read_element(JsconeCursor* cursor, JsconeLexer* lexer, unsigned char in_object)
+{
+    JsconeToken name = {.first = 0, .end = 0};
+    if(in_object)
+    {
+        if(JSCONE_LEXER_GET_FIRST_CHAR(lexer) != '\"')
+        {
+            JSCONE_LEXER_ERROR(lexer, JSCONE_ERROR_SYNTAX, "expected name in object");
+            return JSCONE_FAILURE;
+        }
+        name = lexer->curr;
+
+        if(jscone_lexer_next_token(lexer) == JSCONE_FAILURE)
+        {
+            return JSCONE_FAILURE;
+        }
+        if(JSCONE_LEXER_GET_FIRST_CHAR(lexer) != ':')
+        {
+            JSCONE_LEXER_ERROR(lexer, JSCONE_ERROR_SYNTAX, "expected char :");
+            return JSCONE_FAILURE;
+        }
+        if(jscone_lexer_next_token(lexer) == JSCONE_FAILURE)
+        {
+            return JSCONE_FAILURE;
+        }
+    }
+
+    switch(JSCONE_LEXER_GET_FIRST_CHAR(lexer))
+    {
+        case ',': case ':': case '}': case ']': case '\0':
+            JSCONE_LEXER_ERROR(lexer, JSCONE_ERROR_SYNTAX, "expected value");
+            return JSCONE_FAILURE;
+        default:
+            break;
+    }
+
+    cursor->length = lexer->length; // can be shortened by a \0
+    cursor->first = lexer->curr.first;
+    cursor->end = lexer->curr.end;
+    cursor->name_first = name.first;
+    cursor->name_end = name.end;
+    cursor->in_object = in_object;
+    return JSCONE_SUCCESS;
+}
+
+int jscone_cursor_skip(JsconeLexer* lexer)
+{
+    /* only brackets are matched, anything inside is not checked */
+    size_t depth = 0;
+    while(JSCONE_TRUE)
+    {
+        switch(JSCONE_LEXER_GET_FIRST_CHAR(lexer))
+        {
+            case '{': case '[':
+                depth++;
                 break;
+            case '}': case ']':
+                depth--;
+                break;
+            case '\0':
+                JSCONE_LEXER_ERROR(lexer, JSCONE_ERROR_SYNTAX, "missing closing bracket");
+                return JSCONE_FAILURE;
             default:
-                escaped = JSCONE_FALSE;
                 break;
         }
-        parser.lexer.curr.end++;
+
+        if(depth == 0)
+        {
+            return JSCONE_SUCCESS;
+        }
+
+        if(jscone_lexer_next_token(lexer) == JSCONE_FAILURE)
+        {
+            return JSCONE_FAILURE;
+        }
     }
+}
 
-    return NULL; // should not reach this
+unsigned char jscone_cursor_name_equals(const JsconeCursor* cursor, const char* name, size_t length)
+{
+    size_t name_length;
+    const char* raw = jscone_cursor_name(cursor, &name_length);
+    if(raw == NULL)
+    {
+        return JSCONE_FALSE;
+    }
+
+    if(memchr(raw, '\\', name_length) == NULL)
+    {
+        return name_length == length && memcmp(raw, name, length) == 0;
+    }
+
+    /* has escape sequences so decode it first */
+    JsconeParser parser = {
+        .lexer = jscone_cursor_lexer(cursor),
+        .curr_node = NULL,
+    };
+    parser.lexer.curr.first = cursor->name_first + 1;
+    parser.lexer.curr.end = cursor->name_end;
+
+    char* decoded = jscone_parser_get_string(&parser);
+    unsigned char equal = decoded != NULL && strcmp(decoded, name) == 0;
+    JSCONE_MEM_FREE(decoded);
+    return equal;
 }
 
-void jscone_free(JsconeNode* node)
+
+
+/* structural index */
+
+#define JSCONE_CLASS_QUOTE      0x01
+#define JSCONE_CLASS_BACKSLASH  0x02
+#define JSCONE_CLASS_STRUCTURAL 0x04
+#define JSCONE_CLASS_WHITESPACE 0x08
+#define JSCONE_CLASS_CONTROL    0x10
+#define JSCONE_CLASS_NUL        0x20
+
+static const unsigned char jscone_char_classes[256] = {
+    [0x00] = JSCONE_CLASS_CONTROL | JSCONE_CLASS_NUL,
+    [0x01] = JSCONE_CLASS_CONTROL, [0x02] = JSCONE_CLASS_CONTROL, [0x03] = JSCONE_CLASS_CONTROL,
+    [0x04] = JSCONE_CLASS_CONTROL, [0x05] = JSCONE_CLASS_CONTROL, [0x06] = JSCONE_CLASS_CONTROL,
+    [0x07] = JSCONE_CLASS_CONTROL, [0x08] = JSCONE_CLASS_CONTROL,
+    ['\t'] = JSCONE_CLASS_CONTROL | JSCONE_CLASS_WHITESPACE,
+    ['\n'] = JSCONE_CLASS_CONTROL | JSCONE_CLASS_WHITESPACE,
+    [0x0B] = JSCONE_CLASS_CONTROL, [0x0C] = JSCONE_CLASS_CONTROL,
+    ['\r'] = JSCONE_CLASS_CONTROL | JSCONE_CLASS_WHITESPACE,
+    [0x0E] = JSCONE_CLASS_CONTROL, [0x0F] = JSCONE_CLASS_CONTROL, [0x10] = JSCONE_CLASS_CONTROL,
+    [0x11] = JSCONE_CLASS_CONTROL, [0x12] = JSCONE_CLASS_CONTROL, [0x13] = JSCONE_CLASS_CONTROL,
+    [0x14] = JSCONE_CLASS_CONTROL, [0x15] = JSCONE_CLASS_CONTROL, [0x16] = JSCONE_CLASS_CONTROL,
+    [0x17] = JSCONE_CLASS_CONTROL, [0x18] = JSCONE_CLASS_CONTROL, [0x19] = JSCONE_CLASS_CONTROL,
+    [0x1A] = JSCONE_CLASS_CONTROL, [0x1B] = JSCONE_CLASS_CONTROL, [0x1C] = JSCONE_CLASS_CONTROL,
+    [0x1D] = JSCONE_CLASS_CONTROL, [0x1E] = JSCONE_CLASS_CONTROL, [0x1F] = JSCONE_CLASS_CONTROL,
+    [' '] = JSCONE_CLASS_WHITESPACE,
+    ['\"'] = JSCONE_CLASS_QUOTE,
+    ['\\'] = JSCONE_CLASS_BACKSLASH,
+    ['{'] = JSCONE_CLASS_STRUCTURAL, ['}'] = JSCONE_CLASS_STRUCTURAL,
+    ['['] = JSCONE_CLASS_STRUCTURAL, [']'] = JSCONE_CLASS_STRUCTURAL,
+    [':'] = JSCONE_CLASS_STRUCTURAL, [','] = JSCONE_CLASS_STRUCTURAL,
+};
+
+static int jscone_ctz64(uint64_t x)
 {
-    if(node == NULL)
+#if defined(__GNUC__) || defined(__clang__)
+    return __builtin_ctzll(x);
+#elif defined(_MSC_VER) && defined(_M_X64)
+    unsigned long i;
+    _BitScanForward64(&i, x);
+    return (int)i;
+#else
+    int i = 0;
+    while(!(x & 1))
     {
-        return;
+        x >>= 1;
+        i++;
     }
-    
-    /* find top node */
-    JsconeNode* head = node;
-    while(head->parent != NULL)
+    return i;
+#endif
+}
+
+void jscone_index_init(JsconeIndex* index, size_t* positions, size_t capacity)
+{
+    index->positions = positions;
+    index->capacity = capacity;
+    index->count = 0;
+    index->pos = 0;
+    index->scanned = 0;
+    index->prev_in_string = 0;
+    index->prev_escaped = 0;
+    index->prev_scalar = 0;
+    index->utf8_remaining = 0;
+    index->utf8_min = 0x80;
+    index->utf8_max = 0xBF;
+    index->validate_utf8 = JSCONE_FALSE;
+    index->classify = jscone_classify_scalar;
+
+#ifdef JSCONE_SSE2
+    index->classify = jscone_classify_sse2;
+#endif
+#ifdef JSCONE_AVX2
+    if(__builtin_cpu_supports("avx2"))
     {
-        head = head->parent;
+        index->classify = jscone_classify_avx2;
     }
+#endif
+}
 
-    jscone_node_free(head);
+int jscone_index_fill(JsconeLexer* lexer)
+{
+    JsconeIndex* index = lexer->index;
+
+    /* move positions that haven't been used to the start */
+    size_t remaining = index->count - index->pos;
+    memmove(index->positions, index->positions + index->pos, remaining * sizeof(size_t));
+    index->count = remaining;
+    index->pos = 0;
+
+    JsconeBlockMasks masks;
+    char padded[JSCONE_BLOCK_SIZE];
+    const char* block;
+
+    /* every block adds at most 64 positions */
+    while(index->scanned < lexer->length && index->count + JSCONE_BLOCK_SIZE <= index->capacity)
+    {
+        block = lexer->json + index->scanned;
+        if(lexer->length - index->scanned < JSCONE_BLOCK_SIZE)
+        {
+            /* pad last block with whitespace */
+            memset(padded, ' ', JSCONE_BLOCK_SIZE);
+            memcpy(padded, block, lexer->length - index->scanned);
+            block = padded;
+        }
+
+        index->classify(block, &masks);
+        if(jscone_index_block(index, &masks, lexer) == JSCONE_FAILURE)
+        {
+            return JSCONE_FAILURE;
+        }
+
+        /* most blocks are all ascii so have nothing to check */
+        if(index->validate_utf8 && (masks.high != 0 || index->utf8_remaining != 0) &&
+           jscone_index_utf8(index, block, masks.high, lexer) == JSCONE_FAILURE)
+        {
+            return JSCONE_FAILURE;
+        }
+        index->scanned += JSCONE_BLOCK_SIZE;
+    }
+
+    if(index->scanned >= lexer->length)
+    {
+        index->scanned = lexer->length;
+        if(index->utf8_remaining != 0)
+        {
+            lexer->curr.first = lexer->length;
+            JSCONE_LEXER_ERROR(lexer, JSCONE_ERROR_UTF8, "json ends in the middle of a utf-8 character");
+            return JSCONE_FAILURE;
+        }
+    }
+    return JSCONE_SUCCESS;
 }
 
-void jscone_print(JsconeNode* node)
+int jscone_index_block(JsconeIndex* index, const JsconeBlockMasks* masks, JsconeLexer* lexer)
 {
-    if(node == NULL)
+    const uint64_t even_bits = 0x5555555555555555ull;
+
+    /* find characters escaped by an odd number of backslashes before them */
+    uint64_t backslash = masks->backslash & ~index->prev_escaped;
+    uint64_t follows_escape = (backslash << 1) | index->prev_escaped;
+    uint64_t odd_starts = backslash & ~even_bits & ~follows_escape;
+    uint64_t even_starts = odd_starts + backslash;
+    index->prev_escaped = even_starts < odd_starts; // overflowed into next block
+    uint64_t escaped = (even_bits ^ (even_starts << 1)) & follows_escape;
+
+    /* bits inside strings are between an opening quote (inclusive) and a closing quote (exclusive) */
+    uint64_t quote = masks->quote & ~escaped;
+    uint64_t in_string = quote;
+    in_string ^= in_string << 1;
+    in_string ^= in_string << 2;
+    in_string ^= in_string << 4;
+    in_string ^= in_string << 8;
+    in_string ^= in_string << 16;
+    in_string ^= in_string << 32;
+    in_string ^= index->prev_in_string;
+    index->prev_in_string = 0 - (in_string >> 63);
+
+    /* \0 outside of a string ends the json (if length is incorrect) */
+    uint64_t valid = ~0ull;
+    uint64_t nul = masks->nul & ~in_string;
+    if(nul != 0)
     {
-        return;
+        int end = jscone_ctz64(nul);
+        valid = (1ull << end) - 1;
+        lexer->length = index->scanned + (size_t)end;
     }
 
-    jscone_node_print(node, 0);
+    uint64_t control = masks->control & in_string & valid;
+    if(control != 0)
+    {
+        lexer->curr.first = index->scanned + (size_t)jscone_ctz64(control);
+        JSCONE_LEXER_ERROR(lexer, JSCONE_ERROR_STRING, "invalid control character in string (newline, tab)");
+        return JSCONE_FAILURE;
+    }
+
+    /* first character of every number/true/false/null */
+    uint64_t scalar = ~(masks->structural | masks->whitespace) & ~quote;
+    uint64_t follows_scalar = (scalar << 1) | index->prev_scalar;
+    index->prev_scalar = scalar >> 63;
+    uint64_t scalar_start = scalar & ~follows_scalar;
+
+    uint64_t tokens = (((masks->structural | scalar_start) & ~in_string) | quote) & valid;
+    while(tokens != 0)
+    {
+        index->positions[index->count++] = index->scanned + (size_t)jscone_ctz64(tokens);
+        tokens &= tokens - 1;
+    }
+
+    return JSCONE_SUCCESS;
+}
+
+int jscone_index_utf8(JsconeIndex* index, const char* block, uint64_t high, JsconeLexer* lexer)
+{
+    /* anything after the end of the json is padding */
+    size_t end = lexer->length - index->scanned < JSCONE_BLOCK_SIZE ? lexer->length - index->scanned : JSCONE_BLOCK_SIZE;
+
+    size_t i = 0;
+    unsigned char c;
+    while(i < end)
+    {
+        if(index->utf8_remaining == 0)
+        {
+            /* skip straight to the next byte that starts a character above 0x7F */
+            uint64_t rest = high >> i;
+            if(rest == 0)
+            {
+                break;
+            }
+            i += (size_t)jscone_ctz64(rest);
+            if(i >= end)
+            {
+                break;
+            }
+
+            c = (unsigned char)block[i];
+            index->utf8_min = 0x80;
+            index->utf8_max = 0xBF;
+            if(c >= 0xC2 && c <= 0xDF)
+            {
+                index->utf8_remaining = 1;
+            }
+            else if(c >= 0xE0 && c <= 0xEF)
+            {
+                /* no overlong encodings or surrogates */
+                index->utf8_remaining = 2;
+                index->utf8_min = c == 0xE0 ? 0xA0 : 0x80;
+                index->utf8_max = c == 0xED ? 0x9F : 0xBF;
+            }
+            else if(c >= 0xF0 && c <= 0xF4)
+            {
+                /* no overlong encodings or characters above 0x10FFFF */
+                index->utf8_remaining = 3;
+                index->utf8_min = c == 0xF0 ? 0x90 : 0x80;
+                index->utf8_max = c == 0xF4 ? 0x8F : 0xBF;
+            }
+            else
+            {
+                goto invalid; // continuation byte on its own, or C0, C1, F5 and above which never appear
+            }
+        }
+        else
+        {
+            c = (unsigned char)block[i];
+            if(c < index->utf8_min || c > index->utf8_max)
+            {
+                goto invalid;
+            }
+            index->utf8_remaining--;
+            index->utf8_min = 0x80;
+            index->utf8_max = 0xBF;
+        }
+        i++;
+    }
+
+    return JSCONE_SUCCESS;
+
+    invalid:
+    lexer->curr.first = index->scanned + i;
+    JSCONE_LEXER_ERROR(lexer, JSCONE_ERROR_UTF8, "invalid utf-8");
+    return JSCONE_FAILURE;
+}
+
+void jscone_classify_scalar(const char* block, JsconeBlockMasks* masks)
+{
+    memset(masks, 0, sizeof(JsconeBlockMasks));
+
+    unsigned char c;
+    uint64_t bit;
+    for(unsigned int i = 0; i < JSCONE_BLOCK_SIZE; i++)
+    {
+        masks->high |= (uint64_t)((unsigned char)block[i] >> 7) << i;
+        c = jscone_char_classes[(unsigned char)block[i]];
+        if(c == 0) // most characters
+        {
+            continue;
+        }
+
+        bit = 1ull << i;
+        masks->quote |= (c & JSCONE_CLASS_QUOTE) ? bit : 0;
+        masks->backslash |= (c & JSCONE_CLASS_BACKSLASH) ? bit : 0;
+        masks->structural |= (c & JSCONE_CLASS_STRUCTURAL) ? bit : 0;
+        masks->whitespace |= (c & JSCONE_CLASS_WHITESPACE) ? bit : 0;
+        masks->control |= (c & JSCONE_CLASS_CONTROL) ? bit : 0;
+        masks->nul |= (c & JSCONE_CLASS_NUL) ? bit : 0;
+    }
+}
+
+#ifdef JSCONE_SSE2
+void jscone_classify_sse2(const char* block, JsconeBlockMasks* masks)
+{
+    memset(masks, 0, sizeof(JsconeBlockMasks));
+
+    for(unsigned int i = 0; i < JSCONE_BLOCK_SIZE; i += 16)
+    {
+        __m128i chars = _mm_loadu_si128((const __m128i*)(block + i));
+
+        /* [ and { (also ] and }) only differ by 0x20 */
+        __m128i lower = _mm_or_si128(chars, _mm_set1_epi8(0x20));
+        __m128i structural = _mm_or_si128(
+            _mm_or_si128(_mm_cmpeq_epi8(lower, _mm_set1_epi8('{')), _mm_cmpeq_epi8(lower, _mm_set1_epi8('}'))),
+            _mm_or_si128(_mm_cmpeq_epi8(chars, _mm_set1_epi8(':')), _mm_cmpeq_epi8(chars, _mm_set1_epi8(','))));
+        __m128i whitespace = _mm_or_si128(
+            _mm_or_si128(_mm_cmpeq_epi8(chars, _mm_set1_epi8(' ')), _mm_cmpeq_epi8(chars, _mm_set1_epi8('\t'))),
+            _mm_or_si128(_mm_cmpeq_epi8(chars, _mm_set1_epi8('\n')), _mm_cmpeq_epi8(chars, _mm_set1_epi8('\r'))));
+        __m128i control = _mm_cmpeq_epi8(_mm_min_epu8(chars, _mm_set1_epi8(0x1F)), chars); // unsigned <= 0x1F
+
+        masks->quote |= (uint64_t)(uint32_t)_mm_movemask_epi8(_mm_cmpeq_epi8(chars, _mm_set1_epi8('\"'))) << i;
+        masks->backslash |= (uint64_t)(uint32_t)_mm_movemask_epi8(_mm_cmpeq_epi8(chars, _mm_set1_epi8('\\'))) << i;
+        masks->structural |= (uint64_t)(uint32_t)_mm_movemask_epi8(structural) << i;
+        masks->whitespace |= (uint64_t)(uint32_t)_mm_movemask_epi8(whitespace) << i;
+        masks->control |= (uint64_t)(uint32_t)_mm_movemask_epi8(control) << i;
+        masks->nul |= (uint64_t)(uint32_t)_mm_movemask_epi8(_mm_cmpeq_epi8(chars, _mm_setzero_si128())) << i;
+        masks->high |= (uint64_t)(uint32_t)_mm_movemask_epi8(chars) << i;
+    }
+}
+#endif
+
+#ifdef JSCONE_AVX2
+__attribute__((target("avx2"))) void jscone_classify_avx2(const char* block, JsconeBlockMasks* masks)
+{
+    memset(masks, 0, sizeof(JsconeBlockMasks));
+
+    for(unsigned int i = 0; i < JSCONE_BLOCK_SIZE; i += 32)
+    {
+        __m256i chars = _mm256_loadu_si256((const __m256i*)(block + i));
+
+        /* same as sse2 version */
+        __m256i lower = _mm256_or_si256(chars, _mm256_set1_epi8(0x20));
+        __m256i structural = _mm256_or_si256(
+            _mm256_or_si256(_mm256_cmpeq_epi8(lower, _mm256_set1_epi8('{')), _mm256_cmpeq_epi8(lower, _mm256_set1_epi8('}'))),
+            _mm256_or_si256(_mm256_cmpeq_epi8(chars, _mm256_set1_epi8(':')), _mm256_cmpeq_epi8(chars, _mm256_set1_epi8(','))));
+        __m256i whitespace = _mm256_or_si256(
+            _mm256_or_si256(_mm256_cmpeq_epi8(chars, _mm256_set1_epi8(' ')), _mm256_cmpeq_epi8(chars, _mm256_set1_epi8('\t'))),
+            _mm256_or_si256(_mm256_cmpeq_epi8(chars, _mm256_set1_epi8('\n')), _mm256_cmpeq_epi8(chars, _mm256_set1_epi8('\r'))));
+        __m256i control = _mm256_cmpeq_epi8(_mm256_min_epu8(chars, _mm256_set1_epi8(0x1F)), chars);
+
+        masks->quote |= (uint64_t)(uint32_t)_mm256_movemask_epi8(_mm256_cmpeq_epi8(chars, _mm256_set1_epi8('\"'))) << i;
+        masks->backslash |= (uint64_t)(uint32_t)_mm256_movemask_epi8(_mm256_cmpeq_epi8(chars, _mm256_set1_epi8('\\'))) << i;
+        masks->structural |= (uint64_t)(uint32_t)_mm256_movemask_epi8(structural) << i;
+        masks->whitespace |= (uint64_t)(uint32_t)_mm256_movemask_epi8(whitespace) << i;
+        masks->control |= (uint64_t)(uint32_t)_mm256_movemask_epi8(control) << i;
+        masks->nul |= (uint64_t)(uint32_t)_mm256_movemask_epi8(_mm256_cmpeq_epi8(chars, _mm256_setzero_si256())) << i;
+        masks->high |= (uint64_t)(uint32_t)_mm256_movemask_epi8(chars) << i;
+    }
+}
+#endif
+
+
+
+/* writing */
+
+int jscone_buffer_reserve(JsconeBuffer* buf, size_t extra)
+{
+    if(buf->length + extra <= buf->capacity)
+    {
+        return JSCONE_SUCCESS;
+    }
+
+    size_t capacity = buf->capacity > 0 ? buf->capacity : JSCONE_BUFFER_MIN_CAPACITY;
+    while(capacity < buf->length + extra)
+    {
+        capacity *= 2;
+    }
+
+    char* data = buf->data == NULL ? (char*)JSCONE_MEM_ALLOC(capacity) : (char*)JSCONE_MEM_REALLOC(buf->data, capacity);
+    if(data == NULL)
+    {
+        return JSCONE_FAILURE;
+    }
+    buf->data = data;
+    buf->capacity = capacity;
+    return JSCONE_SUCCESS;
 }
 
-
-
-/**
- * internal functions
- */
-
-JsconeNode* jscone_find_name_in_siblings(JsconeParser* parser, const char* name)
+int jscone_buffer_append(JsconeBuffer* buf, const char* data, size_t length)
 {
-    while(JSCONE_TRUE)
+    if(jscone_buffer_reserve(buf, length) == JSCONE_FAILURE)
     {
-        if(strcmp(name, parser->curr_node->name) == 0)
-        {
-            return parser->curr_node;
-        }
-
-        if(parser->curr_node->next == NULL)
-        {
-            JSCONE_ERROR("could not find name %s\n", name);
-            return NULL;
-        }
-
-        parser->curr_node = parser->curr_node->next;
+        return JSCONE_FAILURE;
     }
 
-    return NULL; // should not be reached
+    memcpy(buf->data + buf->length, data, length);
+    buf->length += length;
+    return JSCONE_SUCCESS;
 }
 
-/* parsing */
-
-int jscone_parser_parse_value(JsconeParser* parser, const char* name)
+int jscone_write_newline(JsconeBuffer* buf, unsigned int indent, unsigned int depth)
 {
-    /* determine type */
-    switch(JSCONE_PARSER_GET_FIRST_CHAR(parser))
+    if(indent == 0)
     {
-        case '{':
-            return jscone_parser_parse_object(parser, name);
-        case '[':
-            return jscone_parser_parse_array(parser, name);
-        case '\"':
-            return jscone_parser_parse_string(parser, name);
-        case '0': case '1': case '2': case '3': case '4':
-        case '5': case '6': case '7': case '8': case '9':
-        case '-': case '.':
-            return jscone_parser_parse_number(parser, name);
-        default:
-            return jscone_parser_parse_enum(parser, name);
+        return JSCONE_SUCCESS;
     }
 
-    return JSCONE_FAILURE; // should not be reached
+    size_t spaces = (size_t)indent * depth;
+    if(jscone_buffer_reserve(buf, spaces + 1) == JSCONE_FAILURE)
+    {
+        return JSCONE_FAILURE;
+    }
+
+    buf->data[buf->length++] = '\n';
+    memset(buf->data + buf->length, ' ', spaces);
+    buf->length += spaces;
+    return JSCONE_SUCCESS;
 }
 
-int jscone_parser_parse_object(JsconeParser* parser, const char* name)
+int jscone_write_string(JsconeBuffer* buf, const char* str, size_t length)
 {
-    JsconeNode* node_before = parser->curr_node;
-    parser->curr_node = jscone_node_create(node_before, JSCONE_OBJECT, (JsconeVal){0});
-    parser->curr_node->name = name;
-    char* curr_name = NULL;
+    static const char hex[] = "0123456789abcdef";
 
-    /* caller should have already gone to next token */
-    JSCONE_EXPECT_FIRST_CHAR(parser, '{', "missing opening bracket for object\n");
-    JSCONE_PARSER_NEXT_TOKEN(parser);
-    while(JSCONE_PARSER_GET_FIRST_CHAR(parser) != '}')
+    /* worst case every character is \u00XX */
+    if(jscone_buffer_reserve(buf, length * 6 + 2) == JSCONE_FAILURE)
     {
-        JSCONE_EXPECT_FIRST_CHAR(parser, '\"', "object name string is missing first quote\n");
-        JSCONE_EXPECT_LAST_CHAR(parser, '\"', "object name string is missing last quote\n");
+        return JSCONE_FAILURE;
+    }
 
-        curr_name = jscone_parser_parse_name(parser);
-        if(curr_name == NULL)
+    char* out = buf->data + buf->length;
+    *out++ = '\"';
+
+    size_t i = 0;
+    while(i < length)
+    {
+        /* copy everything up to the next character that needs escaping at once */
+        size_t plain = jscone_escape_scan(str + i, length - i);
+        memcpy(out, str + i, plain);
+        out += plain;
+        i += plain;
+        if(i == length)
         {
-            return JSCONE_FAILURE;
+            break;
         }
 
-        JSCONE_PARSER_NEXT_TOKEN(parser);
-        if(JSCONE_PARSER_GET_FIRST_CHAR(parser) != ':') // expect char macro but free name as well
+        unsigned char c = (unsigned char)str[i++];
+        *out++ = '\\';
+        switch(c)
         {
-            JSCONE_PARSER_ERROR(parser, "expected char :\n");
-            free((void*)curr_name);
-            return JSCONE_FAILURE;
+            case '\"': *out++ = '\"'; break;
+            case '\\': *out++ = '\\'; break;
+            case '\b': *out++ = 'b'; break;
+            case '\f': *out++ = 'f'; break;
+            case '\n': *out++ = 'n'; break;
+            case '\r': *out++ = 'r'; break;
+            case '\t': *out++ = 't'; break;
+            default:
+                *out++ = 'u';
+                *out++ = '0';
+                *out++ = '0';
+                *out++ = hex[c >> 4];
+                *out++ = hex[c & 0xF];
+                break;
         }
+    }
 
+    *out++ = '\"';
+    buf->length = (size_t)(out - buf->data);
+    return JSCONE_SUCCESS;
+}
 
-        JSCONE_PARSER_NEXT_TOKEN(parser);
-        if(jscone_parser_parse_value(parser, curr_name) == JSCONE_FAILURE)
-        {
-            free((void*)curr_name);
-            return JSCONE_FAILURE;
-        }
+size_t jscone_escape_scan(const char* str, size_t length)
+{
+    size_t i = 0;
+#ifdef JSCONE_SSE2
+    /* quote, backslash or control character (<= 0x1F unsigned) */
+    for(; i + 16 <= length; i += 16)
+    {
+        __m128i chars = _mm_loadu_si128((const __m128i*)(str + i));
+        __m128i escape = _mm_or_si128(
+            _mm_or_si128(_mm_cmpeq_epi8(chars, _mm_set1_epi8('\"')), _mm_cmpeq_epi8(chars, _mm_set1_epi8('\\'))),
+            _mm_cmpeq_epi8(_mm_max_epu8(chars, _mm_set1_epi8(0x1F)), _mm_set1_epi8(0x1F)));
 
-        JSCONE_PARSER_NEXT_TOKEN(parser);
-        if(JSCONE_PARSER_GET_FIRST_CHAR(parser) == ',')
-        {
-            JSCONE_PARSER_NEXT_TOKEN(parser);
-        }
-        else
+        int mask = _mm_movemask_epi8(escape);
+        if(mask != 0)
         {
-            JSCONE_EXPECT_FIRST_CHAR(parser, '}', "missing comma or closing brace for object\n");
+            return i + (size_t)jscone_ctz64((uint64_t)(unsigned int)mask);
         }
     }
-    
-    /* special case for root node */
-    if(node_before != NULL)
+#endif
+
+    for(; i < length; i++)
     {
-        /* reset curr_node to go back up the tree so next calls work */
-        parser->curr_node = node_before;
+        if(jscone_char_classes[(unsigned char)str[i]] & (JSCONE_CLASS_QUOTE | JSCONE_CLASS_BACKSLASH | JSCONE_CLASS_CONTROL))
+        {
+            return i;
+        }
     }
-    return JSCONE_SUCCESS;
+    return length;
 }
 
-int jscone_parser_parse_array(JsconeParser* parser, const char* name)
+int jscone_write_number(JsconeBuffer* buf, double num)
 {
-    JsconeNode* node_before = parser->curr_node;
-    parser->curr_node = jscone_node_create(node_before, JSCONE_ARRAY, (JsconeVal){0});
-    parser->curr_node->name = name;
+    if(num != num || num == HUGE_VAL || num == -HUGE_VAL)
+    {
+        return jscone_buffer_append(buf, "null", 4);
+    }
 
-    /* caller should have already gone to next token */
-    JSCONE_EXPECT_FIRST_CHAR(parser, '[', "missing opening bracket for object\n");
-    JSCONE_PARSER_NEXT_TOKEN(parser);
-    while(JSCONE_PARSER_GET_FIRST_CHAR(parser) != ']')
+    /* whole numbers are common and easy */
+    if(num > -(double)JSCONE_MAX_EXACT_INT && num < (double)JSCONE_MAX_EXACT_INT && num == (double)(int64_t)num)
     {
-        if(jscone_parser_parse_value(parser, name) == JSCONE_FAILURE) // keep all names same in array
+        if(num == 0.0 && signbit(num))
         {
-            return JSCONE_FAILURE;
+            return jscone_buffer_append(buf, "-0", 2);
         }
+        return jscone_write_integer(buf, (int64_t)num);
+    }
 
-        JSCONE_PARSER_NEXT_TOKEN(parser);
-        if(JSCONE_PARSER_GET_FIRST_CHAR(parser) == ',')
+    /*
+     * fewest digits that parse back to the same double, 17 always do and once some do more do too so it can be bisected,
+     * %g drops trailing zeros so if 15 do (most numbers from json) it has already found how many at most
+     */
+    char str[JSCONE_NUM_BUFFER_SIZE];
+    int length = snprintf(str, sizeof(str), "%.15g", num);
+    int low = 1;
+    int high = 17;
+    if(strtod(str, NULL) == num)
+    {
+        high = jscone_significant_digits(str, (size_t)length);
+    }
+    else
+    {
+        low = 16;
+    }
+
+    while(low < high)
+    {
+        int precision = (low + high) / 2;
+        length = snprintf(str, sizeof(str), "%.*g", precision, num);
+        if(length > 0 && strtod(str, NULL) == num)
         {
-            JSCONE_PARSER_NEXT_TOKEN(parser);
+            high = precision;
         }
         else
         {
-            JSCONE_EXPECT_FIRST_CHAR(parser, ']', "missing comma or closing brace for object\n");
+            low = precision + 1;
         }
     }
+    length = snprintf(str, sizeof(str), "%.*g", high, num);
 
-    /* special case for root node */
-    if(node_before != NULL)
+    /* snprintf uses the locale's decimal point */
+    char* point = memchr(str, localeconv()->decimal_point[0], (size_t)length);
+    if(point != NULL)
     {
-        /* reset curr_node to go back up the tree so next calls work */
-        parser->curr_node = node_before;
+        *point = '.';
+    }
+    else if(memchr(str, 'e', (size_t)length) == NULL)
+    {
+        /* big whole numbers would be parsed back as JSCONE_INT */
+        str[length++] = '.';
+        str[length++] = '0';
     }
-    return JSCONE_SUCCESS;
-}
 
-char* jscone_parser_parse_name(JsconeParser* parser)
-{
-    parser->lexer.curr.first++; // move past first "
-    return jscone_parser_get_string(parser);
+    return jscone_buffer_append(buf, str, (size_t)length);
 }
 
-int jscone_parser_parse_string(JsconeParser* parser, const char* name)
+int jscone_significant_digits(const char* str, size_t length)
 {
-    parser->lexer.curr.first++; // move past first "
-    char* string = jscone_parser_get_string(parser);
-    if(string == NULL)
+    /* digits from the first that isn't 0 up to the exponent */
+    int digits = 0;
+    for(size_t i = 0; i < length && str[i] != 'e'; i++)
     {
-        return JSCONE_FAILURE;
+        if(JSCONE_IS_DIGIT(str[i]) && (digits > 0 || str[i] != '0'))
+        {
+            digits++;
+        }
     }
 
-    JsconeNode* node = jscone_node_create(parser->curr_node, JSCONE_STRING, (JsconeVal){.str = string});
-    node->name = name;
-    
-    return JSCONE_SUCCESS;
+    return digits > 0 ? digits : 1;
 }
 
-int jscone_parser_parse_number(JsconeParser* parser, const char* name)
+int jscone_write_integer(JsconeBuffer* buf, int64_t integer)
 {
-    double num = 0.0f;
+    /* digits are made backwards */
+    char str[24];
+    char* end = str + sizeof(str);
+    char* digits = end;
 
-    unsigned int length = JSCONE_PARSER_TOKEN_LENGTH(parser);
-    char* num_str = JSCONE_STR_ALLOC((length + 1) * sizeof(char));
-    memset(num_str, 0, length + 1);
-    strncpy(num_str, parser->lexer.json + parser->lexer.curr.first, length);
+    uint64_t magnitude = integer < 0 ? (uint64_t)0 - (uint64_t)integer : (uint64_t)integer;
+    do
+    {
+        *--digits = (char)('0' + magnitude % 10);
+        magnitude /= 10;
+    } while(magnitude != 0);
 
-    errno = 0;
-    num = strtod(num_str, NULL);
-    free(num_str);
-    if(errno != 0)
+    if(integer < 0)
     {
-        JSCONE_PARSER_ERROR(parser, "could not convert number; errno = %d: %s", errno, strerror(errno));
-        return JSCONE_FAILURE;
+        *--digits = '-';
     }
 
-
-    JsconeNode* node = jscone_node_create(parser->curr_node, JSCONE_NUM, (JsconeVal){.num = num});
-    node->name = name;
-    return JSCONE_SUCCESS;
+    return jscone_buffer_append(buf, digits, (size_t)(end - digits));
 }
 
-int jscone_parser_parse_enum(JsconeParser* parser, const char* name)
-{
-    const char* token_start = parser->lexer.json + parser->lexer.curr.first;
-    unsigned int length = JSCONE_PARSER_TOKEN_LENGTH(parser);
 
-    if(length > 5 || length < 4)
-    {
-        JSCONE_PARSER_ERROR(parser, "characters wrong size to be true/false/null enum\n");
-        return JSCONE_FAILURE;
-    }
 
-    JsconeType type;
-    JsconeVal value;
-    if(strncmp(token_start, "true", length) == 0)
+/* nodes */
+
+JsconeNode* jscone_node_create(JsconeNode* parent, JsconeType type, JsconeVal value)
+{
+    /* children come from their tree's allocator, adding one can also grow or free the parent's vector/table */
+    const JsconeAllocator* allocator = jscone_allocator_use(parent != NULL ? jscone_node_allocator(parent) : jscone_allocator);
+    JsconeNode* node = jscone_node_alloc(parent);
+    if(node != NULL)
     {
-        type = JSCONE_BOOL;
-        value = (JsconeVal){.bool = JSCONE_TRUE};
+        jscone_node_init(node, parent, type, value);
+        node->flags |= parent == NULL ? JSCONE_NODE_TREE : 0;
     }
-    else if(strncmp(token_start, "false", length) == 0)
+    jscone_allocator_use(allocator);
+
+    return node;
+}
+
+JsconeNode* jscone_node_alloc(const JsconeNode* parent)
+{
+    if(parent != NULL)
     {
-        type = JSCONE_BOOL;
-        value = (JsconeVal){.bool = JSCONE_FALSE};
+        return (JsconeNode*)JSCONE_MEM_ALLOC(sizeof(JsconeNode));
     }
-    else if(strncmp(token_start, "null", length) == 0)
+
+    /* root keeps the allocator for the rest of the tree */
+    JsconeTree* tree = (JsconeTree*)JSCONE_MEM_ALLOC(sizeof(JsconeTree));
+    if(tree == NULL)
     {
-        type = JSCONE_NULL;
-        value = (JsconeVal){0};
+        return NULL;
     }
-    else
+    tree->allocator = jscone_allocator;
+    return &tree->node;
+}
+
+const JsconeAllocator* jscone_node_allocator(const JsconeNode* node)
+{
+    while(node->parent != NULL)
     {
-        JSCONE_PARSER_ERROR(parser, "characters do not match true/false/null enums\n");
-        return JSCONE_FAILURE;
+        node = node->parent;
     }
 
-    JsconeNode* node = jscone_node_create(parser->curr_node, type, value);
-    node->name = name;
-
-    return JSCONE_SUCCESS;
+    return (node->flags & JSCONE_NODE_TREE) ? ((const JsconeTree*)node)->allocator : jscone_allocator;
 }
 
-char* jscone_parser_get_string(JsconeParser* parser)
+void jscone_node_init(JsconeNode* node, JsconeNode* parent, JsconeType type, JsconeVal value)
 {
-    unsigned int length = JSCONE_PARSER_TOKEN_LENGTH(parser) - 1; // since end is 1 past the last " and first is one past the first "
-    char* string = (char*)JSCONE_STR_ALLOC((length + 1) * sizeof(char));
-    memset(string, 0, length + 1);
+    node->parent = parent;
+    node->type = type;
+    node->flags = 0;
+    node->value = value;
+    node->child = NULL;
+    node->last = NULL;
+    node->count = 0;
+    node->prev = NULL;
+    node->next = NULL;
+    node->name = NULL;
 
-    char c;
-    unsigned int str_i = 0; 
-    unsigned char escaped = JSCONE_FALSE;
-    for(unsigned int i = 0; i < length + 1; i++) // assume starting after first " and include last " in loop
+    /* automatically insert child correctly */
+    if(parent != NULL)
     {
-        c = parser->lexer.json[parser->lexer.curr.first + i];
-        if(c == '\\')
+        if(parent->flags & JSCONE_NODE_INDEXED)
         {
-            if(escaped)
-            {
-                string[str_i++] = c;
-            }
-            escaped = !escaped;
-            continue;
+            jscone_elements_add(parent, node);
         }
-        else if(c == '\"')
+
+        /* hash table is out of date, made again on next lookup */
+        if(parent->flags & JSCONE_NODE_HASHED)
         {
-            if(!escaped)
+            if(!(parent->flags & JSCONE_NODE_ARENA))
             {
-                break;
+                JSCONE_MEM_FREE(parent->value.members);
             }
-            string[str_i++] = c;
-            escaped = !escaped;
+            parent->value.members = NULL;
+            parent->flags &= ~(unsigned int)JSCONE_NODE_HASHED;
+        }
+
+        if(parent->child == NULL)
+        {
+            parent->child = node;
+        }
+        else
+        {
+            parent->last->next = node;
+            node->prev = parent->last;
+        }
+        parent->last = node;
+        parent->count++;
+    }
+}
+
+void jscone_node_free(JsconeNode* node)
+{
+    /* frees node, the siblings after it and all their children, children go first so parents are still there to check */
+    JsconeNode* top = node->parent;
+    while(node != NULL)
+    {
+        if(node->child != NULL)
+        {
+            node = node->child;
             continue;
         }
 
-        /* handle escape sequence */
-        if(escaped)
+        if(node->name != NULL && (node->parent == NULL || node->parent->type != JSCONE_ARRAY)) // array sub-nodes have same name ptr as parent array node
         {
-            char bytes[5];
-            unsigned char length = jscone_parse_escape_sequence(parser, i, bytes);
-            if(length == 0)
+            JSCONE_MEM_FREE((void*)node->name);
+        }
+        if(node->value.str != NULL && node->type == JSCONE_STRING)
+        {
+            JSCONE_MEM_FREE(node->value.str);
+        }
+        if(node->flags & JSCONE_NODE_HASHED)
+        {
+            JSCONE_MEM_FREE(node->value.members);
+        }
+        if(node->flags & JSCONE_NODE_INDEXED)
+        {
+            JSCONE_MEM_FREE(node->value.elements);
+        }
+
+        JsconeNode* next = node->next;
+        JsconeNode* parent = node->parent;
+        JSCONE_MEM_FREE(node);
+
+        if(next != NULL)
+        {
+            node = next;
+        }
+        else if(parent != top)
+        {
+            parent->child = NULL; // parent is freed next
+            node = parent;
+        }
+        else
+        {
+            node = NULL;
+        }
+    }
+}
+
+void jscone_node_print(JsconeNode* node, unsigned int indent)
+{
+    /* prints node, the siblings after it and all their children, going down with child and back up with parent */
+    JsconeNode* top = node->parent;
+    while(node != NULL)
+    {
+        if(indent > JSCONE_MAX_INDENT)
+        {
+            /* skip these siblings */
+            JSCONE_ERROR(JSCONE_ERROR_DEPTH, "cannot print json output, beyond max indentation");
+            node = node->parent;
+            indent--;
+        }
+        else
+        {
+            jscone_node_print_value(node, indent);
+            if(node->child != NULL)
             {
-                free(string);
-                return NULL;
+                node = node->child;
+                indent++;
+                continue;
             }
+        }
 
-            for(unsigned char j = 0; j < length; j++)
+        /* next sibling of node or of the closest parent that has one */
+        while(node != NULL && node->next == NULL)
+        {
+            node = node->parent;
+            indent--;
+            if(node == top)
             {
-                string[str_i++] = bytes[j];
+                return;
             }
+        }
+        if(node != NULL)
+        {
+            node = node->next;
+        }
+    }
+}
+
+void jscone_node_print_value(const JsconeNode* node, unsigned int indent)
+{
+    static char indent_str[JSCONE_MAX_INDENT * JSCONE_INDENT_SIZE + 1];
+    memset(indent_str, 0, JSCONE_MAX_INDENT * JSCONE_INDENT_SIZE + 1);
+
+    if(node->name == NULL && node->parent == NULL)
+    {
+        printf("(root node) ");
+    }
+
+    memset(indent_str, ' ', indent * JSCONE_INDENT_SIZE);
+
+    printf("%sname: %s, ", indent_str, node->name);
+
+    printf("type: %s, ", jscone_get_type_name(node->type));
 
-            if(parser->lexer.json[parser->lexer.curr.first + i] == 'u') // skip 4 unicode hex characters
+    switch(node->type)
+    {
+        case JSCONE_STRING:
+            if(node->flags & JSCONE_NODE_RAW)
             {
-                i += 4;
+                printf("value: %.*s\n", (int)node->value.slice->length, node->value.slice->str);
+                break;
             }
-            escaped = JSCONE_FALSE;
-            continue;
-        }
-        string[str_i++] = c;
+            printf("value: %s\n", node->value.str);
+            break;
+        case JSCONE_NUM:
+            printf("value: %lf\n", node->value.num);
+            break;
+        case JSCONE_INT:
+            printf("value: %lld\n", (long long)node->value.integer);
+            break;
+        case JSCONE_BOOL:
+            printf("value: %s\n", node->value.bool ? "true" : "false");
+            break;
+        default: 
+            printf("\b\b \n"); // back twice to overwrite comma with space so no trailing comma
+            break;
     }
-
-    /* set size to minimum - choosing to ignore this */
-    //string = realloc(string, (str_i + 1) * sizeof(char));
-    //string[str_i] = '\0';
-
-    return string;
 }
 
 
 
-/* lexing */
+/* symbols */
 
-int jscone_lexer_next_token(JsconeLexer* lexer)
+const char* jscone_symbols_intern(JsconeSymbolTable* symbols, const char* name, size_t length)
 {
-    lexer->curr.first = lexer->curr.end;
+    if((symbols->count + 1) * 2 > symbols->capacity && jscone_symbols_grow(symbols) == JSCONE_FAILURE)
+    {
+        return NULL;
+    }
 
-    /* skip whitespace */
-    while(JSCONE_TRUE)
+    uint64_t hash = jscone_hash(name, length);
+    size_t mask = symbols->capacity - 1;
+    size_t i = (size_t)hash & mask;
+    for(; symbols->slots[i].name != NULL; i = (i + 1) & mask)
     {
-        if(lexer->curr.first >= lexer->length - 1)
+        const JsconeSymbolSlot* slot = &symbols->slots[i];
+        if(slot->hash == hash && slot->length == length && memcmp(slot->name, name, length) == 0)
         {
-            lexer->curr.end = lexer->curr.first;
-            return JSCONE_SUCCESS;
+            return slot->name;
         }
+    }
 
-        switch(lexer->json[lexer->curr.first])
-        {
-            case '\0': // if length is incorrect
-                lexer->curr.end = --lexer->curr.first;
-                return JSCONE_SUCCESS;
-
-            case '\r': case '\t': case ' ':
-                lexer->curr.first++;
-                break;
-            case '\n': 
-                lexer->line_num++;
-                lexer->curr.first++;
-                break;
-
-            default:
-                goto begin_lexing;
-        }
+    /* symbol goes just before the name */
+    char* copy = (char*)jscone_arena_alloc(&symbols->arena, sizeof(unsigned int) + length + 1, sizeof(unsigned int));
+    if(copy == NULL)
+    {
+        return NULL;
     }
 
-    begin_lexing:
+    unsigned int symbol = (unsigned int)++symbols->count;
+    memcpy(copy, &symbol, sizeof(unsigned int));
+    copy += sizeof(unsigned int);
+    memcpy(copy, name, length);
+    copy[length] = '\0';
 
-    lexer->curr.end = lexer->curr.first;
+    symbols->slots[i] = (JsconeSymbolSlot){.name = copy, .length = length, .hash = hash};
+    return copy;
+}
 
-    while(JSCONE_TRUE)
+int jscone_symbols_grow(JsconeSymbolTable* symbols)
+{
+    size_t capacity = symbols->capacity * 2;
+    JsconeSymbolSlot* slots = (JsconeSymbolSlot*)JSCONE_MEM_ALLOC(capacity * sizeof(JsconeSymbolSlot));
+    if(slots == NULL)
     {
-        if(lexer->curr.end > lexer->length - 1) // can be one past end (on \0)
+        return JSCONE_FAILURE;
+    }
+    memset(slots, 0, capacity * sizeof(JsconeSymbolSlot));
+
+    size_t mask = capacity - 1;
+    for(size_t i = 0; i < symbols->capacity; i++)
+    {
+        if(symbols->slots[i].name == NULL)
         {
-            return JSCONE_SUCCESS;
+            continue;
         }
 
-        switch(lexer->json[lexer->curr.end])
+        size_t j = (size_t)symbols->slots[i].hash & mask;
+        while(slots[j].name != NULL)
         {
-            case '\0':
-                return JSCONE_SUCCESS;
+            j = (j + 1) & mask;
+        }
+        slots[j] = symbols->slots[i];
+    }
 
-            case '{': case '}':
-            case '[': case ']':
-            case ':': case ',':
-                /* only if not coming from contiguous characters */
-                if(lexer->curr.first == lexer->curr.end)
-                {
-                    lexer->curr.end++;
-                }
+    JSCONE_MEM_FREE(symbols->slots);
+    symbols->slots = slots;
+    symbols->capacity = capacity;
+    return JSCONE_SUCCESS;
+}
 
-                return JSCONE_SUCCESS;
 
-            case '\"':
-                /* check if coming from contiguous characters */
-                if(lexer->curr.first < lexer->curr.end)
-                {
-                    JSCONE_LEXER_ERROR(lexer, "unexpected char \"\n");
-                    return JSCONE_FAILURE;
-                }
 
-                return jscone_lexer_lex_string(lexer);
+/* allocation */
 
-            case '\r': case '\t': case ' ':
-                /* have reached end of contiguous characters  */
-                return JSCONE_SUCCESS;
-            case '\n':
-                lexer->line_num++; 
-                return JSCONE_SUCCESS;
+static void* jscone_default_alloc(void* ctx, size_t size)
+{
+    (void)ctx;
+    return JSCONE_ALLOC(size);
+}
 
-            default:
-                /* contiguous characters (could be a number, true/false, null or invalid token) */
-                lexer->curr.end++;
-                break;
-        }
-    }
+static void* jscone_default_realloc(void* ctx, void* ptr, size_t size)
+{
+    (void)ctx;
+    return JSCONE_REALLOC(ptr, size);
+}
+
+static void jscone_default_free(void* ctx, void* ptr)
+{
+    (void)ctx;
+    JSCONE_FREE(ptr);
+}
+
+static const JsconeAllocator* jscone_allocator_use(const JsconeAllocator* allocator)
+{
+    /* returns the one that was set so it can be put back */
+    const JsconeAllocator* previous = jscone_allocator;
+    jscone_allocator = allocator;
+    return previous;
+}
+
+
+
+/* arena */
 
+int jscone_arena_init(JsconeArena* arena, size_t block_size)
+{
+    arena->head = NULL;
+    arena->block_size = block_size < JSCONE_ARENA_MIN_BLOCK_SIZE ? JSCONE_ARENA_MIN_BLOCK_SIZE : block_size;
+    arena->allocator = jscone_allocator;
+
+    /* allocate first block up front so an empty arena is never returned */
+    if(jscone_arena_alloc(arena, 0, 1) == NULL)
+    {
+        return JSCONE_FAILURE;
+    }
     return JSCONE_SUCCESS;
 }
 
-int jscone_lexer_lex_string(JsconeLexer* lexer)
+void* jscone_arena_alloc(JsconeArena* arena, size_t size, size_t align)
 {
-    unsigned char escaped = JSCONE_FALSE;
+    JsconeArenaBlock* block = arena->head;
+    size_t offset = 0;
 
-    /* skip first " */
-    lexer->curr.end++;
+    if(block != NULL)
+    {
+        offset = (block->used + align - 1) & ~(align - 1);
+    }
 
-    while(JSCONE_TRUE)
+    if(block == NULL || offset + size > block->size)
     {
-        if(lexer->curr.end > lexer->length - 1) // one past end
+        /* grow geometrically so the amount of blocks stays small, and fit big allocations */
+        size_t block_size = arena->block_size;
+        while(block_size < size)
         {
-            JSCONE_LEXER_ERROR(lexer, "expected char \" before end of file\n");
-            return JSCONE_FAILURE; // reached EOF before end of string
+            block_size *= 2;
         }
 
-        switch(lexer->json[lexer->curr.end])
+        block = (JsconeArenaBlock*)arena->allocator->alloc(arena->allocator->ctx, sizeof(JsconeArenaBlock) + block_size);
+        if(block == NULL)
         {
-            case '\0':
-                JSCONE_LEXER_ERROR(lexer, "expected char \" before end of file\n");
-                return JSCONE_FAILURE; // reached EOF before end of string
-
-            case '\\':
-                /* toggle escaped incase it is escaping a backslash */
-                escaped = !escaped;
-                lexer->curr.end++;
-                break;
+            return NULL;
+        }
+        block->next = arena->head;
+        block->size = block_size;
+        block->used = 0;
 
-            case '\"':
-                lexer->curr.end++;
+        arena->head = block;
+        arena->block_size = block_size * 2;
+        offset = 0;
+    }
 
-                /* only end string if quote is not escaped */
-                if(!escaped)
-                {
-                    return JSCONE_SUCCESS;
-                }
+    block->used = offset + size;
+    return (char*)(block + 1) + offset;
+}
 
-                escaped = JSCONE_FALSE;
-                break;
+void jscone_arena_free(JsconeArena* arena)
+{
+    JsconeArenaBlock* block = arena->head;
+    JsconeArenaBlock* next;
+    while(block != NULL)
+    {
+        next = block->next;
+        arena->allocator->free(arena->allocator->ctx, block);
+        block = next;
+    }
 
-            case '\r': case '\n': case '\t':
-                JSCONE_LEXER_ERROR(lexer, "invalid whitespace in string (newline, tab)\n");
-                return JSCONE_FAILURE;
+    arena->head = NULL;
+}
 
-            
-            default:
-                /* characters of string */
-                lexer->curr.end++;
-                escaped = JSCONE_FALSE;
-                break;
-        }
+void jscone_arena_reset(JsconeArena* arena)
+{
+    /* keep the newest block since it is the biggest */
+    JsconeArenaBlock* block = arena->head;
+    if(block == NULL)
+    {
+        return;
     }
-}
 
+    arena->head = block->next;
+    jscone_arena_free(arena);
 
+    block->next = NULL;
+    block->used = 0;
+    arena->head = block;
+}
 
-/* nodes */
+/* tape */
 
-JsconeNode* jscone_node_create(JsconeNode* parent, JsconeType type, JsconeVal value)
+int jscone_tape_push(JsconeTape* tape, unsigned char tag, size_t payload)
 {
-    JsconeNode* node = (JsconeNode*)JSCONE_ALLOC(sizeof(JsconeNode));
-
-    node->parent = parent;
-    node->type = type;
-    node->value = value;
-    node->child = NULL;
-    node->prev = NULL;
-    node->next = NULL;
-    node->name = NULL;
-
-    /* automatically insert child correctly */
-    if(parent != NULL)
+    /* always keep room for 1 more entry (number bits) */
+    if(tape->length + 2 > tape->capacity)
     {
-        if(parent->child == NULL)
+        size_t capacity = tape->capacity * 2;
+        uint64_t* entries = (uint64_t*)JSCONE_MEM_REALLOC(tape->entries, capacity * sizeof(uint64_t));
+        if(entries == NULL)
         {
-            parent->child = node;
-            return node;
+            return JSCONE_FAILURE;
         }
+        tape->entries = entries;
+        tape->capacity = capacity;
+    }
 
-        // other children already exist
-        JsconeNode* last_child = parent->child;
-        while(last_child->next != NULL)
-        {
-            last_child = last_child->next;
-        }
-        last_child->next = node;
-        node->prev = last_child;
+    if(tape->keyed)
+    {
+        tag |= JSCONE_TAPE_KEYED;
+        tape->keyed = JSCONE_FALSE;
     }
 
-    return node;
+    tape->entries[tape->length++] = JSCONE_TAPE_ENTRY(tag, payload);
+    return JSCONE_SUCCESS;
 }
 
-void jscone_node_free(JsconeNode* node)
+size_t jscone_tape_skip(const JsconeTape* tape, size_t index)
 {
-    if(node->name != NULL && node->parent->type != JSCONE_ARRAY) // array sub-nodes have same name ptr as parent array node
+    switch(JSCONE_TAPE_TAG(tape->entries[index]) & ~JSCONE_TAPE_KEYED)
     {
-        free((void*)node->name);
+        case JSCONE_TAPE_OBJECT_START: case JSCONE_TAPE_ARRAY_START:
+            return JSCONE_TAPE_PAYLOAD(tape->entries[index]) + 1; // one past end
+        case JSCONE_TAPE_NUM: case JSCONE_TAPE_INT:
+            return index + 2;
+        default:
+            return index + 1;
     }
-    if(node->value.str != NULL && node->type == JSCONE_STRING)
+}
+
+/* compact nodes */
+
+int jscone_compact_build(JsconeCompact* compact, const JsconeTape* tape)
+{
+    /* offsets and indexes have to fit in 32 bits */
+    if(compact->strings_length >= JSCONE_COMPACT_NO_NAME)
     {
-        free(node->value.str);
+        JSCONE_ERROR(JSCONE_ERROR_MEMORY, "strings too big for compact nodes");
+        return JSCONE_FAILURE;
     }
 
-    if(node->next != NULL)
+    /* one node for every value, keys and ends of objects/arrays don't get one */
+    size_t count = 0;
+    unsigned char tag;
+    for(size_t i = 0; i < tape->length; i++)
     {
-        jscone_node_free(node->next);
+        tag = (unsigned char)(JSCONE_TAPE_TAG(tape->entries[i]) & ~JSCONE_TAPE_KEYED);
+        if(tag == JSCONE_TAPE_KEY || tag == JSCONE_TAPE_OBJECT_END || tag == JSCONE_TAPE_ARRAY_END)
+        {
+            continue;
+        }
+
+        count++;
+        if(tag == JSCONE_TAPE_NUM || tag == JSCONE_TAPE_INT)
+        {
+            i++; // skip the number's bits
+        }
     }
-    if(node->child != NULL)
+    if(count > JSCONE_COMPACT_NO_NAME)
     {
-        jscone_node_free(node->child);
+        JSCONE_ERROR(JSCONE_ERROR_MEMORY, "too many values for compact nodes");
+        return JSCONE_FAILURE;
     }
 
-    free(node);
-}
-
-void jscone_node_print(JsconeNode* node, unsigned int indent)
-{
-    static char indent_str[JSCONE_MAX_INDENT * JSCONE_INDENT_SIZE + 1];
-    memset(indent_str, 0, JSCONE_MAX_INDENT * JSCONE_INDENT_SIZE + 1);
-    if(indent > JSCONE_MAX_INDENT)
+    compact->nodes = (JsconeCompactNode*)JSCONE_MEM_ALLOC(count * sizeof(JsconeCompactNode));
+    if(compact->nodes == NULL)
     {
-        JSCONE_ERROR("cannot print json output, beyond max indentation\n");
-        return;
+        JSCONE_ERROR(JSCONE_ERROR_MEMORY, "could not allocate compact nodes");
+        return JSCONE_FAILURE;
     }
 
-    if(node->name == NULL && node->parent == NULL)
+    /* breadth first so every object/array's values end up next to each other */
+    jscone_compact_set(&compact->nodes[JSCONE_COMPACT_ROOT], tape, JSCONE_TAPE_ROOT);
+    compact->count = 1;
+    for(size_t i = 0; i < compact->count; i++)
     {
-        printf("(root node) ");
-    }
+        JsconeCompactNode* node = &compact->nodes[i];
+        if(node->type != JSCONE_OBJECT && node->type != JSCONE_ARRAY)
+        {
+            continue;
+        }
 
-    memset(indent_str, ' ', indent * JSCONE_INDENT_SIZE);
+        /* value is the tape index until now */
+        size_t first = compact->count;
+        for(size_t child = jscone_tape_child(tape, (size_t)node->value); child != JSCONE_TAPE_NONE; child = jscone_tape_next(tape, child))
+        {
+            jscone_compact_set(&compact->nodes[compact->count++], tape, child);
+        }
+        node->value = (uint64_t)first | ((uint64_t)(compact->count - first) << 32);
+    }
 
-    printf("%sname: %s, ", indent_str, node->name);
+    return JSCONE_SUCCESS;
+}
 
-    printf("type: %s, ", jscone_get_type_name(node->type));
+void jscone_compact_set(JsconeCompactNode* node, const JsconeTape* tape, size_t tape_index)
+{
+    uint64_t entry = tape->entries[tape_index];
+    node->type = (uint32_t)jscone_tape_type(tape, tape_index);
+    node->name = JSCONE_COMPACT_NO_NAME;
+    if(JSCONE_TAPE_TAG(entry) & JSCONE_TAPE_KEYED)
+    {
+        node->name = (uint32_t)JSCONE_TAPE_PAYLOAD(tape->entries[tape_index - 1]);
+    }
 
     switch(node->type)
     {
-        case JSCONE_STRING:
-            printf("value: %s\n", node->value.str);
+        case JSCONE_NUM: case JSCONE_INT:
+            node->value = tape->entries[tape_index + 1];
             break;
-        case JSCONE_NUM:
-            printf("value: %lf\n", node->value.num);
+        case JSCONE_STRING:
+            node->value = JSCONE_TAPE_PAYLOAD(entry);
             break;
         case JSCONE_BOOL:
-            printf("value: %s\n", node->value.bool ? "true" : "false");
+            node->value = (JSCONE_TAPE_TAG(entry) & ~JSCONE_TAPE_KEYED) == JSCONE_TAPE_TRUE;
             break;
-        default: 
-            printf("\b\b \n"); // back twice to overwrite comma with space so no trailing comma
+        case JSCONE_OBJECT: case JSCONE_ARRAY:
+            node->value = tape_index; // replaced with its children once they are added
+            break;
+        default:
+            node->value = 0;
             break;
     }
+}
+
+size_t jscone_compact_member(const JsconeCompact* compact, size_t index, const char* name)
+{
+    size_t count = jscone_compact_len(compact, index);
+    if(count == 0)
+    {
+        return JSCONE_COMPACT_NONE;
+    }
 
-    if(node->child != NULL)
+    /* arrays are indexed */
+    size_t first = (size_t)(compact->nodes[index].value & 0xFFFFFFFFu);
+    if(compact->nodes[index].type == JSCONE_ARRAY)
     {
-        jscone_node_print(node->child, indent + 1);
+        size_t n = jscone_path_index(name);
+        return n < count ? first + n : JSCONE_COMPACT_NONE;
     }
 
-    if(node->next != NULL)
+    /* values are next to each other so this stays in a few cache lines */
+    const char* child_name;
+    for(size_t i = first; i < first + count; i++)
     {
-        jscone_node_print(node->next, indent);
+        child_name = jscone_compact_name(compact, i);
+        if(child_name != NULL && strcmp(child_name, name) == 0)
+        {
+            return i;
+        }
     }
+
+    return JSCONE_COMPACT_NONE;
 }
 
 static const char* jscone_get_type_name(JsconeType type)
 {
-    static const char* type_names[JSCONE_TYPE_COUNT] = {"NULL", "BOOL", "NUM", "STRING", "OBJECT", "ARRAY"};
+    static const char* type_names[JSCONE_TYPE_COUNT] = {"NULL", "BOOL", "NUM", "STRING", "OBJECT", "ARRAY", "INT"};
     return type_names[type];
 }
 
-unsigned char jscone_parse_escape_sequence(JsconeParser* parser, unsigned int offset, char* bytes)
+unsigned char jscone_parse_escape_sequence(JsconeParser* parser, size_t offset, char* bytes)
 {
-    unsigned char ret;
     const char* cp = &parser->lexer.json[parser->lexer.curr.first + offset];
+    unsigned int codepoint;
+    unsigned int low;
     switch(*cp)
     {
-        case 'u':
-            ret = jscone_codepoint_to_utf8(bytes, ++cp); // only case that size can be other than 1
-            if(ret == 0)
+        case 'u': // only case that size can be other than 1
+            if(jscone_hex_codepoint(cp + 1, &codepoint) == JSCONE_FAILURE)
             {
-                JSCONE_PARSER_ERROR(parser, "invalid hex for unicode escape sequence");
+                JSCONE_PARSER_ERROR(parser, JSCONE_ERROR_STRING, "invalid hex for unicode escape sequence");
+                return 0;
             }
-            return ret;
+            if(codepoint >= 0xD800 && codepoint <= 0xDFFF)
+            {
+                /* characters above 0xFFFF are written as a high surrogate then a low one */
+                if(codepoint > 0xDBFF || cp[5] != '\\' || cp[6] != 'u' ||
+                   jscone_hex_codepoint(cp + 7, &low) == JSCONE_FAILURE || low < 0xDC00 || low > 0xDFFF)
+                {
+                    JSCONE_PARSER_ERROR(parser, JSCONE_ERROR_STRING, "unpaired surrogate in unicode escape sequence");
+                    return 0;
+                }
+                codepoint = 0x10000 + ((codepoint - 0xD800) << 10) + (low - 0xDC00);
+            }
+            return jscone_codepoint_to_utf8(bytes, codepoint);
         case '/':
             bytes[0] = '/';
             break;
@@ -933,45 +6693,45 @@ unsigned char jscone_parse_escape_sequence(JsconeParser* parser, unsigned int of
             bytes[0] = '\t';
             break;
         default:
-            JSCONE_PARSER_ERROR(parser, "invalid escape sequence char %c\n", *cp);
+            JSCONE_PARSER_ERROR(parser, JSCONE_ERROR_STRING, "invalid escape sequence char");
             return 0; // 0 length (error)
     }
 
     return 1;
 }
 
-/* thank you https://gist.github.com/MightyPork/52eda3e5677b4b03524e40c9f0ab1da5 */
-unsigned char jscone_codepoint_to_utf8(char* bytes, const char* codepoint_str)
+int jscone_hex_codepoint(const char* hex, unsigned int* codepoint)
 {
-    unsigned int codepoint = 0;
-
+    *codepoint = 0;
     for(unsigned int i = 0; i < 4; i++)
     {
-        char c = *(codepoint_str++);
-        if(c == '\0')
-        {
-            return 0; // 0 length (hex too short error)
-        }
-        codepoint = (codepoint << 4);
+        char c = hex[i];
+        *codepoint <<= 4;
 
         if('0' <= c && c <= '9')
         {
-            codepoint += (unsigned int)(c - '0');
+            *codepoint += (unsigned int)(c - '0');
         }
         else if('a' <= c && c <= 'f')
         {
-            codepoint += (unsigned int)(c - 'a' + 10);
+            *codepoint += (unsigned int)(c - 'a' + 10);
         }
         else if('A' <= c && c <= 'F')
         {
-            codepoint += (unsigned int)(c - 'A' + 10);
+            *codepoint += (unsigned int)(c - 'A' + 10);
         }
         else
         {
-            return 0; // 0 length (invalid hex characters error)
+            return JSCONE_FAILURE; // too short (stops at " or \0) or not hex
         }
     }
 
+    return JSCONE_SUCCESS;
+}
+
+/* thank you https://gist.github.com/MightyPork/52eda3e5677b4b03524e40c9f0ab1da5 */
+unsigned char jscone_codepoint_to_utf8(char* bytes, unsigned int codepoint)
+{
     if(codepoint <= 0x7F)
     {
         /* plain ascii */
@@ -997,13 +6757,14 @@ unsigned char jscone_codepoint_to_utf8(char* bytes, const char* codepoint_str)
         return 3;
     }
     else
-    { 
-        /* error - use replacement character */
-        bytes[0] = (char)0xEF;  
-        bytes[1] = (char)0xBF;
-        bytes[2] = (char)0xBD;
-        bytes[3] = 0;
-        return 0;
+    {
+        /* 4-byte unicode, from a surrogate pair so never above 0x10FFFF */
+        bytes[0] = (char)(((codepoint >> 18) & 0x07) | 0xF0);
+        bytes[1] = (char)(((codepoint >> 12) & 0x3F) | 0x80);
+        bytes[2] = (char)(((codepoint >>  6) & 0x3F) | 0x80);
+        bytes[3] = (char)(((codepoint >>  0) & 0x3F) | 0x80);
+        bytes[4] = 0;
+        return 4;
     }
 }
 
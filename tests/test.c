@@ -76,7 +76,7 @@ void test_print_var(u8 num, const char* msg, ...)
 
 void test_allocate_string(char** ptr, char* string)
 {
-    unsigned int length = (unsigned int)strlen(string);
+    size_t length = strlen(string);
     *ptr = malloc((length + 1) * sizeof(char));
     strncpy(*ptr, string, length + 1);
 }
@@ -11,13 +11,14 @@ TEST(multiple_child_nodes)
 
     const char* string = "string";
 
-    JsconeVal values[6] = {
+    JsconeVal values[7] = {
         (JsconeVal){0},
         (JsconeVal){.bool = JSCONE_TRUE},
         (JsconeVal){.num = 3.0f},
         (JsconeVal){.str = test_parser_allocate_string(string)},
         (JsconeVal){0},
         (JsconeVal){0},
+        (JsconeVal){.integer = 9007199254740993},
     };
 
     for(int i = 0; i < JSCONE_TYPE_COUNT; i++)
@@ -47,4 +48,368 @@ TEST(multiple_child_nodes)
     return TEST_SUCCESS;
 }
 
+TEST(get_member)
+{
+    /* wide object, last key is a duplicate */
+    char json[8 * 1024];
+    size_t length = (size_t)sprintf(json, "{");
+    for(int i = 0; i < 200; i++)
+    {
+        length += (size_t)sprintf(json + length, "\"key%d\": %d, ", i, i);
+    }
+    length += (size_t)sprintf(json + length, "\"key7\": -1, \"nested\": {\"a\": true}}");
+
+    JsconeNode* root = jscone_parse(json, (u32)length);
+    TEST_ASSERT(root != NULL);
+    TEST_ASSERT(jscone_get_member(root, "key0", 4) == root->child);
+    TEST_ASSERT(!(root->flags & JSCONE_NODE_HASHED));
+    TEST_ASSERT(jscone_get_member(root, "key150", 6)->value.num == 150.0);
+    TEST_ASSERT(root->flags & JSCONE_NODE_HASHED);
+
+    char key[16];
+    for(int i = 0; i < 200; i++)
+    {
+        int key_length = sprintf(key, "key%d", i);
+        JsconeNode* node = jscone_get_member(root, key, (size_t)key_length);
+        TEST_ASSERT(node != NULL && node->value.num == (f64)i);
+    }
+    TEST_ASSERT(jscone_get_member(root, "key200", 6) == NULL);
+    TEST_ASSERT(jscone_get_member(root, "key1", 3) == NULL); // only "key" matches first 3 characters
+    TEST_ASSERT(jscone_find(root, "/nested/a")->value.bool == JSCONE_TRUE);
+
+    /* adding a child makes the table again */
+    JsconeNode* added = jscone_node_create(root, JSCONE_NULL, (JsconeVal){0});
+    added->name = test_parser_allocate_string("added");
+    TEST_ASSERT(!(root->flags & JSCONE_NODE_HASHED));
+    TEST_ASSERT(jscone_get_member(root, "added", 5) == added);
+    TEST_ASSERT(jscone_get_member(root, "key199", 6)->value.num == 199.0);
+    jscone_free(root);
+
+    /* documents only get tables when asked */
+    JsconeOptions options = {.block_size = 0, .flags = JSCONE_HASH_MEMBERS};
+    JsconeDocument* doc = jscone_parse_document(json, (u32)length, &options);
+    TEST_ASSERT(doc != NULL && (doc->root->flags & JSCONE_NODE_HASHED));
+    TEST_ASSERT(!(jscone_get_member(doc->root, "nested", 6)->flags & JSCONE_NODE_HASHED)); // too small
+    TEST_ASSERT(jscone_get_member(doc->root, "key7", 4)->value.num == 7.0);
+    jscone_document_free(doc);
+
+    doc = jscone_parse_document(json, (u32)length, NULL);
+    TEST_ASSERT(jscone_get_member(doc->root, "key150", 6)->value.num == 150.0);
+    TEST_ASSERT(!(doc->root->flags & JSCONE_NODE_HASHED));
+    jscone_document_free(doc);
+
+    return TEST_SUCCESS;
+}
+
+TEST(array_access)
+{
+    char json[64 * 1024];
+    size_t length = (size_t)sprintf(json, "{\"items\": [");
+    for(int i = 0; i < 5000; i++)
+    {
+        length += (size_t)sprintf(json + length, "%s{\"v\": %d}", i ? ", " : "", i);
+    }
+    length += (size_t)sprintf(json + length, "], \"10\": true}");
+
+    JsconeNode* root = jscone_parse(json, (u32)length);
+    TEST_ASSERT(root != NULL && root->count == 2);
+    JsconeNode* items = root->child;
+    TEST_ASSERT(jscone_array_len(items) == 5000 && (items->flags & JSCONE_NODE_INDEXED));
+    TEST_ASSERT(items->last == jscone_array_get(items, 4999) && items->last->next == NULL);
+    TEST_ASSERT(jscone_array_get(items, 1234)->child->value.num == 1234.0);
+    TEST_ASSERT(jscone_array_get(items, 5000) == NULL);
+    TEST_ASSERT(jscone_array_len(root) == 0 && jscone_array_get(root, 0) == NULL);
+
+    TEST_ASSERT(jscone_find(root, "/items/1234/v")->value.num == 1234.0);
+    TEST_ASSERT(jscone_find(root, "/10")->value.bool == JSCONE_TRUE); // objects still use names
+    JsconePath* path = jscone_path_compile("/items/4321/v");
+    TEST_ASSERT(jscone_path_eval(root, path)->value.num == 4321.0);
+    jscone_path_free(path);
+    path = jscone_path_compile("/items/5000");
+    TEST_ASSERT(jscone_path_eval(root, path) == NULL);
+    jscone_path_free(path);
+
+    /* names that aren't indexes aren't found in arrays, even the array's own name its values share */
+    TEST_ASSERT(jscone_find(root, "/items/items") == NULL && jscone_find(root, "/items/v") == NULL);
+    path = jscone_path_compile("/items/items");
+    TEST_ASSERT(jscone_path_eval(root, path) == NULL);
+    jscone_path_free(path);
+
+    /* appending keeps vector, count and last up to date */
+    for(int i = 0; i < 100; i++)
+    {
+        jscone_node_create(items, JSCONE_NUM, (JsconeVal){.num = (f64)i});
+    }
+    TEST_ASSERT(jscone_array_len(items) == 5100 && (items->flags & JSCONE_NODE_INDEXED));
+    TEST_ASSERT(jscone_array_get(items, 5099)->value.num == 99.0 && items->last == jscone_array_get(items, 5099));
+    TEST_ASSERT(jscone_array_get(items, 5000)->prev == jscone_array_get(items, 4999));
+    jscone_free(root);
+
+    /* arrays built by hand */
+    JsconeNode* arr = jscone_node_create(NULL, JSCONE_ARRAY, (JsconeVal){0});
+    for(int i = 0; i < 10; i++)
+    {
+        jscone_node_create(arr, JSCONE_NUM, (JsconeVal){.num = (f64)i});
+    }
+    TEST_ASSERT(!(arr->flags & JSCONE_NODE_INDEXED));
+    TEST_ASSERT(jscone_find(arr, "/foo") == NULL && jscone_find(arr, "foo") == NULL);
+    TEST_ASSERT(jscone_array_get(arr, 7)->value.num == 7.0 && (arr->flags & JSCONE_NODE_INDEXED));
+    TEST_ASSERT(jscone_find(arr, "/3")->value.num == 3.0);
+    jscone_free(arr);
+
+    /* documents */
+    JsconeDocument* doc = jscone_parse_document(json, (u32)length, NULL);
+    TEST_ASSERT(jscone_array_get(doc->root->child, 2500)->child->value.num == 2500.0);
+    jscone_document_free(doc);
+    doc = jscone_parse_parallel(json + 10, (u32)(strchr(json, ']') - json) - 9, NULL, 3);
+    TEST_ASSERT(doc != NULL && jscone_array_len(doc->root) == 5000);
+    TEST_ASSERT(jscone_array_get(doc->root, 4999) == doc->root->last);
+    TEST_ASSERT(jscone_array_get(doc->root, 3333)->child->value.num == 3333.0);
+    jscone_document_free(doc);
+
+    return TEST_SUCCESS;
+}
+
+typedef struct
+{
+    long allocations;
+    long reallocations;
+    long live;
+#ifdef JSCONE_THREADS
+    pthread_mutex_t mutex; // parse_many workers allocate too
+#endif
+} TestAllocator;
+
+static void* test_alloc(void* ctx, size_t size)
+{
+    TestAllocator* counts = (TestAllocator*)ctx;
+#ifdef JSCONE_THREADS
+    pthread_mutex_lock(&counts->mutex);
+#endif
+    counts->allocations++;
+    counts->live++;
+#ifdef JSCONE_THREADS
+    pthread_mutex_unlock(&counts->mutex);
+#endif
+    return malloc(size);
+}
+
+static void* test_realloc(void* ctx, void* ptr, size_t size)
+{
+    TestAllocator* counts = (TestAllocator*)ctx;
+#ifdef JSCONE_THREADS
+    pthread_mutex_lock(&counts->mutex);
+#endif
+    counts->reallocations++;
+#ifdef JSCONE_THREADS
+    pthread_mutex_unlock(&counts->mutex);
+#endif
+    return realloc(ptr, size);
+}
+
+static void test_free(void* ctx, void* ptr)
+{
+    TestAllocator* counts = (TestAllocator*)ctx;
+#ifdef JSCONE_THREADS
+    pthread_mutex_lock(&counts->mutex);
+#endif
+    counts->live--;
+#ifdef JSCONE_THREADS
+    pthread_mutex_unlock(&counts->mutex);
+#endif
+    free(ptr);
+}
+
+static int test_many_keep(void* user, JsconeNode* root)
+{
+    (void)user;
+    (void)root;
+    return JSCONE_SUCCESS;
+}
+
+TEST(allocator)
+{
+    TestAllocator counts = {0};
+#ifdef JSCONE_THREADS
+    pthread_mutex_init(&counts.mutex, NULL);
+#endif
+    JsconeAllocator allocator = {.ctx = &counts, .alloc = test_alloc, .realloc = test_realloc, .free = test_free};
+    jscone_set_allocator(&allocator);
+
+    char json[16 * 1024];
+    size_t length = (size_t)sprintf(json, "[");
+    for(int i = 0; i < 300; i++)
+    {
+        length += (size_t)sprintf(json + length, "%s{\"id\": %d, \"s\": \"a\\n%d\", \"v\": [1, 2]}", i ? ", " : "", i, i);
+    }
+    length += (size_t)sprintf(json + length, "]");
+
+    /* everything that allocates gives it all back */
+    JsconeNode* root = jscone_parse(json, (u32)length);
+    TEST_ASSERT(root != NULL && counts.allocations > 300);
+    TEST_ASSERT(jscone_find(root, "/299/s") != NULL && jscone_array_get(root, 5) != NULL);
+    JsconeNode* wide = jscone_node_create(root, JSCONE_OBJECT, (JsconeVal){0});
+    for(int i = 0; i < 40; i++)
+    {
+        char name[16];
+        sprintf(name, "k%d", i);
+        JsconeNode* child = jscone_node_create(wide, JSCONE_NULL, (JsconeVal){0});
+        child->name = (char*)allocator.alloc(allocator.ctx, strlen(name) + 1);
+        strcpy((char*)child->name, name);
+    }
+    TEST_ASSERT(jscone_get_member(wide, "k39", 3) != NULL && (wide->flags & JSCONE_NODE_HASHED));
+    JsconePath* path = jscone_path_compile("/10/v/1");
+    TEST_ASSERT(jscone_path_eval(root, path)->value.num == 2.0);
+    jscone_path_free(path);
+    JsconeBuffer buf = {0};
+    TEST_ASSERT(jscone_write(root, &buf, NULL) == JSCONE_SUCCESS);
+    jscone_buffer_free(&buf);
+    jscone_free(root);
+    TEST_ASSERT(counts.live == 0);
+
+    JsconeSymbolTable* symbols = jscone_symbols_new();
+    JsconeOptions options = {.block_size = 0, .flags = JSCONE_HASH_MEMBERS, .symbols = symbols, .max_depth = 0};
+    JsconeDocument* doc = jscone_parse_document(json, (u32)length, &options);
+    TEST_ASSERT(doc != NULL);
+    jscone_document_free(doc);
+    jscone_symbols_free(symbols);
+    doc = jscone_parse_parallel(json, (u32)length, NULL, 2);
+    TEST_ASSERT(doc != NULL);
+    jscone_document_free(doc);
+    TEST_ASSERT(jscone_parse_many(json, (u32)length, 2, test_many_keep, NULL) == JSCONE_SUCCESS);
+    jscone_tape_free(jscone_parse_tape(json, (u32)length));
+    JsconeStream* stream = jscone_stream_new(NULL, NULL);
+    TEST_ASSERT(jscone_stream_feed(stream, json, (u32)length) == JSCONE_SUCCESS);
+    TEST_ASSERT(jscone_stream_finish(stream, &root) == JSCONE_SUCCESS);
+    jscone_free(root);
+    JsconeCursor cursor;
+    TEST_ASSERT(jscone_cursor_init(&cursor, json, (u32)length) == JSCONE_SUCCESS && jscone_cursor_first_element(&cursor) == JSCONE_SUCCESS);
+    TEST_ASSERT(jscone_cursor_find_field(&cursor, "s") == JSCONE_SUCCESS);
+    char* str = jscone_cursor_get_string(&cursor);
+    TEST_ASSERT(str != NULL && strcmp(str, "a\n0") == 0);
+    jscone_string_free(str);
+    TEST_ASSERT(counts.live == 0);
+
+    /* documents, trees, tapes, compact nodes and streams are freed with the allocator they were made with */
+    doc = jscone_parse_document(json, (u32)length, NULL);
+    root = jscone_parse(json, (u32)length);
+    JsconeTape* tape = jscone_parse_tape(json, (u32)length);
+    JsconeCompact* compact = jscone_parse_compact(json, (u32)length);
+    stream = jscone_stream_new(NULL, NULL);
+    TEST_ASSERT(doc != NULL && root != NULL && tape != NULL && compact != NULL && stream != NULL);
+    TEST_ASSERT(root->flags & JSCONE_NODE_TREE);
+    long allocations = counts.allocations;
+    jscone_set_allocator(NULL);
+    JsconeNode* other = jscone_parse(json, (u32)length);
+    jscone_free(other);
+    TEST_ASSERT(counts.allocations == allocations);
+
+    /* and anything added to them later comes from it too */
+    wide = jscone_node_create(root, JSCONE_OBJECT, (JsconeVal){0});
+    for(int i = 0; i < 40; i++)
+    {
+        jscone_node_create(wide, JSCONE_NULL, (JsconeVal){0});
+    }
+    TEST_ASSERT(jscone_get_member(wide, "k", 1) == NULL && (wide->flags & JSCONE_NODE_HASHED));
+    JsconeNode* items = jscone_node_create(root, JSCONE_ARRAY, (JsconeVal){0});
+    jscone_node_create(items, JSCONE_NUM, (JsconeVal){.num = 1.0});
+    TEST_ASSERT(jscone_array_get(items, 0) != NULL && (items->flags & JSCONE_NODE_INDEXED));
+    TEST_ASSERT(counts.allocations == allocations + 45);
+
+    TEST_ASSERT(jscone_stream_feed(stream, json, (u32)length) == JSCONE_SUCCESS);
+    TEST_ASSERT(jscone_stream_finish(stream, &other) == JSCONE_SUCCESS);
+    TEST_ASSERT(counts.allocations > allocations + 45);
+    jscone_free(other);
+    jscone_free(root);
+    jscone_tape_free(tape);
+    jscone_compact_free(compact);
+    jscone_document_free(doc);
+    TEST_ASSERT(counts.live == 0);
+
+    /* and trees made without one aren't freed with one set later */
+    root = jscone_parse(json, (u32)length);
+    TEST_ASSERT(root != NULL);
+    jscone_set_allocator(&allocator);
+    allocations = counts.allocations;
+    jscone_node_create(jscone_array_get(root, 0), JSCONE_NULL, (JsconeVal){0});
+    jscone_free(root);
+    TEST_ASSERT(counts.allocations == allocations && counts.live == 0);
+    jscone_set_allocator(NULL);
+
+#ifdef JSCONE_THREADS
+    pthread_mutex_destroy(&counts.mutex);
+#endif
+    return TEST_SUCCESS;
+}
+
+TEST(context)
+{
+    TestAllocator counts = {0};
+#ifdef JSCONE_THREADS
+    pthread_mutex_init(&counts.mutex, NULL);
+#endif
+    JsconeAllocator allocator = {.ctx = &counts, .alloc = test_alloc, .realloc = test_realloc, .free = test_free};
+    jscone_set_allocator(&allocator);
+    JsconeOptions options = {.block_size = 0, .flags = JSCONE_HASH_MEMBERS, .symbols = NULL, .max_depth = 0};
+    JsconeContext* context = jscone_context_new(&options);
+    TEST_ASSERT(context != NULL);
+    jscone_set_allocator(NULL); // context keeps the allocator it was made with
+
+    /* wide object, long array and nesting deep enough for the depth stack to move to the heap */
+    char json[8 * 1024];
+    size_t length = (size_t)sprintf(json, "{");
+    for(int i = 0; i < 40; i++)
+    {
+        length += (size_t)sprintf(json + length, "\"k%d\": \"v\\t%d\", ", i, i);
+    }
+    length += (size_t)sprintf(json + length, "\"items\": [");
+    for(int i = 0; i < 200; i++)
+    {
+        length += (size_t)sprintf(json + length, "%s%d", i ? ", " : "", i);
+    }
+    length += (size_t)sprintf(json + length, "], \"deep\": ");
+    for(int i = 0; i < 100; i++)
+    {
+        json[length++] = '[';
+    }
+    for(int i = 0; i < 100; i++)
+    {
+        json[length++] = ']';
+    }
+    json[length++] = '}';
+
+    /* after warming up parsing allocates nothing */
+    JsconeDocument* doc = NULL;
+    for(int i = 0; i < 4; i++)
+    {
+        doc = jscone_context_parse(context, json, (u32)length);
+        TEST_ASSERT(doc != NULL);
+    }
+    long allocations = counts.allocations + counts.reallocations;
+    long live = counts.live;
+    for(int i = 0; i < 100; i++)
+    {
+        doc = jscone_context_parse(context, json, (u32)length);
+        TEST_ASSERT(doc != NULL);
+        JsconeNode* member = jscone_get_member(doc->root, "k39", 3);
+        TEST_ASSERT(member != NULL && strcmp(member->value.str, "v\t39") == 0);
+        TEST_ASSERT(jscone_find(doc->root, "/items/199")->value.num == 199.0);
+    }
+    TEST_ASSERT(counts.allocations + counts.reallocations == allocations && counts.live == live);
+
+    /* failing doesn't break the context */
+    TEST_ASSERT(jscone_context_parse(context, "{\"a\": }", 7) == NULL);
+    TEST_ASSERT(jscone_last_error().code != JSCONE_ERROR_NONE);
+    doc = jscone_context_parse(context, "[1, 2]", 6);
+    TEST_ASSERT(doc != NULL && jscone_array_len(doc->root) == 2);
+
+    jscone_context_free(context);
+    TEST_ASSERT(counts.live == 0);
+
+#ifdef JSCONE_THREADS
+    pthread_mutex_destroy(&counts.mutex);
+#endif
+    return TEST_SUCCESS;
+}
+
 END_TESTS()
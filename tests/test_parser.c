@@ -13,7 +13,6 @@ TEST(parse_string)
             .json = test_string,
             .length = (u32)strlen(test_string),
             .curr = {.first = 0, .end = 0},
-            .line_num = 1,
         },
         .curr_node = node,
     };
@@ -44,7 +43,6 @@ TEST(parse_number)
             .json = test_string,
             .length = (u32)strlen(test_string),
             .curr = {.first = 0, .end = 0},
-            .line_num = 1,
         },
         .curr_node = node,
     };
@@ -67,6 +65,85 @@ TEST(parse_number)
     return TEST_SUCCESS;
 }
 
+TEST(parse_number_exact)
+{
+    JsconeNode* node = jscone_node_create(NULL, JSCONE_NULL, (JsconeVal){0});
+    const char* test_string = "9007199254740993 -9223372036854775808 9223372036854775807 "
+                              "0.1 -0.0 123456789012345678901234 2.2250738585072014e-308 "
+                              "0.30000000000000004 1e23 1.7976931348623157e308 0.000123e-2 "
+                              "10000000000000000000 100000000000000000000 9223372036854775808 -9223372036854775809";
+    JsconeType types[3] = {JSCONE_INT, JSCONE_INT, JSCONE_INT};
+    i64 integers[3] = {9007199254740993, INT64_MIN, INT64_MAX};
+
+    JsconeParser parser = {
+        .lexer = {
+            .json = test_string,
+            .length = (u32)strlen(test_string),
+            .curr = {.first = 0, .end = 0},
+        },
+        .curr_node = node,
+    };
+
+    TEST_ASSERT(jscone_lexer_next_token(&parser.lexer) == JSCONE_SUCCESS);
+
+    for(int i = 0; i < 3; i++)
+    {
+        TEST_ASSERT(jscone_parser_parse_number(&parser, NULL) == JSCONE_SUCCESS);
+        TEST_ASSERT(node->child->type == types[i]);
+        TEST_ASSERT(node->child->value.integer == integers[i]);
+
+        jscone_node_free(node->child);
+        node->child = NULL;
+        TEST_ASSERT(jscone_lexer_next_token(&parser.lexer) == JSCONE_SUCCESS);
+    }
+
+    /* doubles should round the same as strtod */
+    while(parser.lexer.curr.first < parser.lexer.length)
+    {
+        TEST_ASSERT(jscone_parser_parse_number(&parser, NULL) == JSCONE_SUCCESS);
+        TEST_ASSERT(node->child->type == JSCONE_NUM);
+        f64 expected = strtod(test_string + parser.lexer.curr.first, NULL);
+        TEST_ASSERT(memcmp(&node->child->value.num, &expected, sizeof(f64)) == 0);
+
+        jscone_node_free(node->child);
+        node->child = NULL;
+        TEST_ASSERT(jscone_lexer_next_token(&parser.lexer) == JSCONE_SUCCESS);
+    }
+
+    jscone_node_free(node);
+
+    /* longer than strtod's buffer, only whether any digit past the ones kept isn't 0 changes the rounding */
+    char long_number[2048];
+    const char* endings[3] = {"", "1", "0"};
+    for(int i = 0; i < 3; i++)
+    {
+        size_t length = (size_t)sprintf(long_number, "[9007199254740993");
+        memset(long_number + length, '0', 1000);
+        length += 1000;
+        length += (size_t)sprintf(long_number + length, "%se-%d]", endings[i], 1000 + (int)strlen(endings[i]));
+        node = jscone_parse(long_number, (u32)length);
+        f64 expected = strtod(long_number + 1, NULL);
+        TEST_ASSERT(node != NULL && node->child->type == JSCONE_NUM && memcmp(&node->child->value.num, &expected, sizeof(f64)) == 0);
+        jscone_free(node);
+    }
+    memset(long_number, '0', 1500);
+    memcpy(long_number, "[-0.", 4);
+    memcpy(long_number + 1500, "17e1490]", 9);
+    node = jscone_parse(long_number, (u32)strlen(long_number));
+    f64 expected = strtod(long_number + 1, NULL);
+    TEST_ASSERT(node != NULL && node->child->type == JSCONE_NUM && memcmp(&node->child->value.num, &expected, sizeof(f64)) == 0);
+    jscone_free(node);
+
+    const char* invalid[6] = {"[01]", "[1.]", "[.5]", "[-]", "[1e]", "[1e400]"};
+    for(int i = 0; i < 6; i++)
+    {
+        node = jscone_parse(invalid[i], (u32)strlen(invalid[i]));
+        TEST_ASSERT(node == NULL);
+    }
+
+    return TEST_SUCCESS;
+}
+
 TEST(parse_enum)
 {
     JsconeNode* node = jscone_node_create(NULL, JSCONE_NULL, (JsconeVal){0});
@@ -78,7 +155,6 @@ TEST(parse_enum)
             .json = test_string,
             .length = (u32)strlen(test_string),
             .curr = {.first = 0, .end = 0},
-            .line_num = 1,
         },
         .curr_node = node,
     };
@@ -118,7 +194,6 @@ TEST(parse_empty_array)
             .json = test_string,
             .length = (u32)strlen(test_string),
             .curr = {.first = 0, .end = 0},
-            .line_num = 1,
         },
         .curr_node = node,
     };
@@ -150,7 +225,6 @@ TEST(parse_one_item_array)
             .json = test_string,
             .length = (u32)strlen(test_string),
             .curr = {.first = 0, .end = 0},
-            .line_num = 1,
         },
         .curr_node = node,
     };
@@ -191,7 +265,6 @@ TEST(parse_complex_array)
             .json = test_string,
             .length = (u32)strlen(test_string),
             .curr = {.first = 0, .end = 0},
-            .line_num = 1,
         },
         .curr_node = node,
     };
@@ -246,7 +319,6 @@ TEST(parse_empty_object)
             .json = test_string,
             .length = (u32)strlen(test_string),
             .curr = {.first = 0, .end = 0},
-            .line_num = 1,
         },
         .curr_node = node,
     };
@@ -278,7 +350,6 @@ TEST(parse_one_item_object)
             .json = test_string,
             .length = (u32)strlen(test_string),
             .curr = {.first = 0, .end = 0},
-            .line_num = 1,
         },
         .curr_node = node,
     };
@@ -317,7 +388,6 @@ TEST(parse_complex_object)
             .json = test_string,
             .length = (u32)strlen(test_string),
             .curr = {.first = 0, .end = 0},
-            .line_num = 1,
         },
         .curr_node = node,
     };
@@ -365,4 +435,328 @@ TEST(parse_complex_object)
     return TEST_SUCCESS;
 }
 
+TEST(structural_index)
+{
+    /* escapes and strings crossing the 64 byte blocks */
+    const char* test_string =
+        "{\"a\\\\\": [1, -2.5e3, true, null], \"escaped \\\" quote\": \"ends with backslash \\\\\","
+        "\"long string that goes past the end of the first block and into the next one\": {\"x\":\"\\\\\\\"\"},"
+        "\"n\":false}\n";
+
+    JsconeLexer lexer = {
+        .json = test_string,
+        .length = (u32)strlen(test_string),
+        .curr = {.first = 0, .end = 0},
+    };
+
+    size_t positions[JSCONE_INDEX_CAPACITY];
+    JsconeIndex index;
+    jscone_index_init(&index, positions, JSCONE_INDEX_CAPACITY);
+    JsconeLexer indexed_lexer = lexer;
+    indexed_lexer.index = &index;
+
+    JsconeClassifyFunc classify_funcs[] = {
+        jscone_classify_scalar,
+#ifdef JSCONE_SSE2
+        jscone_classify_sse2,
+#endif
+    };
+
+    for(unsigned int i = 0; i < sizeof(classify_funcs) / sizeof(classify_funcs[0]); i++)
+    {
+        jscone_index_init(&index, positions, JSCONE_INDEX_CAPACITY);
+        index.classify = classify_funcs[i];
+        lexer.curr = (JsconeToken){0};
+        indexed_lexer.curr = (JsconeToken){0};
+
+        do
+        {
+            TEST_ASSERT(jscone_lexer_next_token(&lexer) == JSCONE_SUCCESS);
+            TEST_ASSERT(jscone_lexer_next_token(&indexed_lexer) == JSCONE_SUCCESS);
+            TEST_ASSERT(lexer.curr.first == indexed_lexer.curr.first);
+            TEST_ASSERT(lexer.curr.end == indexed_lexer.curr.end);
+        } while(lexer.curr.first != lexer.curr.end);
+    }
+
+    /* \0 ends the json, control characters are not allowed in strings */
+    const char* nul_terminated = "[1, 2]\0 garbage";
+    JsconeNode* result = jscone_parse(nul_terminated, 16);
+    TEST_ASSERT(result != NULL);
+    jscone_free(result);
+
+    const char* control = "[\"tab\tin string\"]";
+    TEST_ASSERT(jscone_parse(control, (u32)strlen(control)) == NULL);
+
+    return TEST_SUCCESS;
+}
+
+TEST(deep_nesting)
+{
+    /* deeper than the default limit fails cleanly */
+    u32 depth = 100000;
+    char* json = (char*)malloc(depth * 7 + 2);
+    u32 length = 0;
+    for(u32 i = 0; i < depth; i++)
+    {
+        memcpy(json + length, "{\"a\": ", 6);
+        length += 6;
+    }
+    json[length++] = '1';
+    memset(json + length, '}', depth);
+    length += depth;
+
+    TEST_ASSERT(jscone_parse(json, length) == NULL);
+
+    JsconeOptions options = {.block_size = 0, .flags = 0, .symbols = NULL, .max_depth = depth};
+    JsconeDocument* doc = jscone_parse_document(json, length, &options);
+    TEST_ASSERT(doc != NULL);
+    JsconeNode* node = doc->root;
+    for(u32 i = 0; i < depth; i++)
+    {
+        node = node->child;
+    }
+    TEST_ASSERT(node->type == JSCONE_NUM && node->value.num == 1.0);
+    jscone_document_free(doc);
+
+    options.max_depth = depth - 1;
+    TEST_ASSERT(jscone_parse_document(json, length, &options) == NULL);
+    free(json);
+
+    /* freeing doesn't recurse along siblings */
+    u32 count = 300000;
+    json = (char*)malloc(count * 2 + 2);
+    json[0] = '[';
+    for(u32 i = 0; i < count; i++)
+    {
+        json[1 + i * 2] = '0';
+        json[2 + i * 2] = ',';
+    }
+    json[count * 2] = ']';
+    JsconeNode* result = jscone_parse(json, count * 2 + 1);
+    TEST_ASSERT(result != NULL && result->count == count);
+    jscone_free(result);
+    free(json);
+
+    /* or children */
+    JsconeNode* root = jscone_node_create(NULL, JSCONE_ARRAY, (JsconeVal){0});
+    node = root;
+    for(u32 i = 0; i < depth; i++)
+    {
+        node = jscone_node_create(node, JSCONE_ARRAY, (JsconeVal){0});
+    }
+    jscone_free(root);
+
+    return TEST_SUCCESS;
+}
+
+typedef struct
+{
+    int depth;
+    int stop_at;
+} TestDepth;
+
+static int test_start_nested(void* user)
+{
+    TestDepth* depth = (TestDepth*)user;
+    return ++depth->depth == depth->stop_at ? JSCONE_FAILURE : JSCONE_SUCCESS;
+}
+
+TEST(nested_failure)
+{
+    /* a member's name belongs to its node once it is made, so a value failing further in frees it only once */
+    const char* invalid[8] = {
+        "{\"a\": {\"b\": [1, {\"c\": tru}]}}",
+        "{\"a\": [tru]}",
+        "{\"a\": {\"b\": tru}}",
+        "{\"a\": [1, {\"c\": 1}, x]}",
+        "{\"a\": {\"b\": 1}, \"c\": {\"d\": x}}",
+        "{\"a\": {\"b\": {\"c\": \"\\q\"}}}",
+        "[{\"a\": [{\"b\": 1e}]}]",
+        "{\"a\": {\"b\": [1, 2}}",
+    };
+
+    for(int i = 0; i < 8; i++)
+    {
+        u32 length = (u32)strlen(invalid[i]);
+        TEST_ASSERT(jscone_parse(invalid[i], length) == NULL);
+        TEST_ASSERT(jscone_last_error().code != JSCONE_ERROR_NONE);
+        TEST_ASSERT(jscone_parse_document(invalid[i], length, NULL) == NULL);
+
+        JsconeNode* root = NULL;
+        JsconeStream* stream = jscone_stream_new(NULL, NULL);
+        TEST_ASSERT(stream != NULL);
+        jscone_stream_feed(stream, invalid[i], length); // fails here or at the end
+        TEST_ASSERT(jscone_stream_finish(stream, &root) == JSCONE_FAILURE && root == NULL);
+    }
+
+    /* stopping right after the level stack moved to the heap or grew there */
+    char json[2048];
+    const JsconeHandler handler = {.start_object = test_start_nested, .start_array = test_start_nested};
+    const int stops[4] = {33, 34, 65, 129};
+    for(int i = 0; i < 4; i++)
+    {
+        /* only arrays, then only objects so names are freed too */
+        for(int kind = 0; kind < 2; kind++)
+        {
+            u32 length = 0;
+            for(int d = 0; d < 200; d++)
+            {
+                length += (u32)sprintf(json + length, "%s", kind ? "{\"a\": " : "[");
+            }
+            TestDepth depth = {.depth = 0, .stop_at = stops[i]};
+            TEST_ASSERT(jscone_parse_events(json, length, &handler, &depth) == JSCONE_FAILURE);
+            TEST_ASSERT(depth.depth == stops[i] && jscone_last_error().code == JSCONE_ERROR_CALLBACK);
+        }
+    }
+
+    return TEST_SUCCESS;
+}
+
+typedef struct
+{
+    int count;
+    JsconeErrorCode code;
+} TestLog;
+
+static void test_log(void* user, const JsconeError* error)
+{
+    TestLog* log = (TestLog*)user;
+    log->count++;
+    log->code = error->code;
+}
+
+static int test_stop(void* user)
+{
+    (void)user;
+    return JSCONE_FAILURE;
+}
+
+static int test_keep(void* user, JsconeNode* root)
+{
+    (void)user;
+    (void)root;
+    return JSCONE_SUCCESS;
+}
+
+TEST(errors)
+{
+    TestLog log = {0};
+    jscone_set_log(test_log, &log);
+
+    const char* json = "{\n  \"a\": tru\n}";
+    TEST_ASSERT(jscone_parse(json, (u32)strlen(json)) == NULL);
+    JsconeError error = jscone_last_error();
+    TEST_ASSERT(error.code == JSCONE_ERROR_LITERAL && error.byte_offset == 9 && error.message != NULL);
+    TEST_ASSERT(log.count == 1 && log.code == JSCONE_ERROR_LITERAL);
+
+    size_t line, column;
+    TEST_ASSERT(jscone_error_position(json, strlen(json), &error, &line, &column) == JSCONE_SUCCESS);
+    TEST_ASSERT(line == 2 && column == 8);
+    error.byte_offset = 100;
+    TEST_ASSERT(jscone_error_position(json, strlen(json), &error, &line, &column) == JSCONE_FAILURE);
+
+    /* success clears it */
+    JsconeNode* root = jscone_parse("[1]", 3);
+    TEST_ASSERT(root != NULL && jscone_last_error().code == JSCONE_ERROR_NONE);
+    jscone_free(root);
+
+    const char* cases[6] = {"[1, 2] x", "[\"a\nb\"]", "[1.2.3]", "[[[1]]]", "{\"a\" 1}", "[\"\\q\"]"};
+    JsconeErrorCode codes[6] = {JSCONE_ERROR_SYNTAX, JSCONE_ERROR_STRING, JSCONE_ERROR_NUMBER, JSCONE_ERROR_DEPTH, JSCONE_ERROR_SYNTAX, JSCONE_ERROR_STRING};
+    size_t offsets[6] = {7, 3, 1, 2, 5, 2};
+    JsconeOptions options = {.block_size = 0, .flags = 0, .symbols = NULL, .max_depth = 2};
+    for(int i = 0; i < 6; i++)
+    {
+        JsconeDocument* doc = jscone_parse_document(cases[i], (u32)strlen(cases[i]), &options);
+        TEST_ASSERT(doc == NULL);
+        TEST_ASSERT(jscone_last_error().code == codes[i] && jscone_last_error().byte_offset == offsets[i]);
+    }
+
+    /* offsets are from the start of everything given */
+    JsconeStream* stream = jscone_stream_new(NULL, NULL);
+    TEST_ASSERT(jscone_stream_feed(stream, "{\"a\": [1, ", 10) == JSCONE_SUCCESS);
+    TEST_ASSERT(jscone_stream_feed(stream, "2, x]}", 6) == JSCONE_FAILURE);
+    TEST_ASSERT(jscone_last_error().code == JSCONE_ERROR_LITERAL && jscone_last_error().byte_offset == 13);
+    TEST_ASSERT(jscone_stream_finish(stream, NULL) == JSCONE_FAILURE);
+
+    json = "{\"id\": 0}\n{\"id\": 1}\n{\"id\" 2}";
+    TEST_ASSERT(jscone_parse_many(json, (u32)strlen(json), 2, test_keep, NULL) == JSCONE_FAILURE);
+    TEST_ASSERT(jscone_last_error().code == JSCONE_ERROR_SYNTAX && jscone_last_error().byte_offset == (size_t)(strstr(json, "2}") - json));
+
+    json = "[1, 2, 3, {\"a\": nul}, 5]";
+    TEST_ASSERT(jscone_parse_parallel(json, (u32)strlen(json), NULL, 2) == NULL);
+    TEST_ASSERT(jscone_last_error().code == JSCONE_ERROR_LITERAL && jscone_last_error().byte_offset == 16);
+
+    JsconeHandler handler = {.start_array = test_stop};
+    TEST_ASSERT(jscone_parse_events("[1]", 3, &handler, NULL) == JSCONE_FAILURE);
+    TEST_ASSERT(jscone_last_error().code == JSCONE_ERROR_CALLBACK);
+
+    root = jscone_parse("{\"a\": {\"b\": 1}}", 16);
+    TEST_ASSERT(jscone_find(root, "/a/c") == NULL);
+    TEST_ASSERT(jscone_last_error().code == JSCONE_ERROR_NOT_FOUND);
+    jscone_free(root);
+
+    log.count = 0;
+    jscone_set_log(NULL, NULL);
+    TEST_ASSERT(jscone_parse("[", 1) == NULL && log.count == 0);
+
+    return TEST_SUCCESS;
+}
+
+TEST(unicode)
+{
+    /* characters above 0xFFFF are escaped as surrogate pairs */
+    const char* json = "[\"\\u00e9\\u20AC\\ud83d\\ude00!\", \"\xC3\xA9\xE2\x82\xAC\xF0\x9F\x98\x80!\"]";
+    JsconeNode* root = jscone_parse(json, strlen(json));
+    TEST_ASSERT(root != NULL);
+    TEST_ASSERT_STREQUAL(jscone_array_get(root, 0)->value.str, "\xC3\xA9\xE2\x82\xAC\xF0\x9F\x98\x80!");
+    TEST_ASSERT_STREQUAL(jscone_array_get(root, 0)->value.str, jscone_array_get(root, 1)->value.str);
+    jscone_free(root);
+
+    const char* unpaired[4] = {"[\"\\ud83d\"]", "[\"\\ude00\"]", "[\"\\ud83d\\u0041\"]", "[\"\\ud83dx\"]"};
+    for(int i = 0; i < 4; i++)
+    {
+        TEST_ASSERT(jscone_parse(unpaired[i], strlen(unpaired[i])) == NULL);
+        TEST_ASSERT(jscone_last_error().code == JSCONE_ERROR_STRING && jscone_last_error().byte_offset == 2);
+    }
+
+    /* raw utf-8 is only checked when asked for */
+    JsconeOptions options = {.block_size = 0, .flags = JSCONE_VALIDATE_UTF8, .symbols = NULL, .max_depth = 0};
+    JsconeDocument* doc = jscone_parse_document(json, strlen(json), &options);
+    TEST_ASSERT(doc != NULL);
+    jscone_document_free(doc);
+
+    const char* invalid[7] = {
+        "[\"a\x80\"]",             // continuation byte on its own
+        "[\"a\xC3\"]",             // cut off by the quote
+        "[\"a\xC0\xAF\"]",         // overlong
+        "[\"a\xE2\x82\"]",
+        "[\"a\xED\xA0\x80\"]",     // surrogate
+        "[\"a\xF4\x90\x80\x80\"]", // above 0x10FFFF
+        "[1]\xE2",                 // end of json
+    };
+    size_t offsets[7] = {3, 4, 3, 5, 4, 4, 4};
+    for(int i = 0; i < 7; i++)
+    {
+        TEST_ASSERT(jscone_parse_document(invalid[i], strlen(invalid[i]), &options) == NULL);
+        TEST_ASSERT(jscone_last_error().code == JSCONE_ERROR_UTF8 && jscone_last_error().byte_offset == offsets[i]);
+    }
+    root = jscone_parse(invalid[0], strlen(invalid[0]));
+    TEST_ASSERT(root != NULL);
+    jscone_free(root);
+
+    /* characters split between 64 byte blocks */
+    char split[128];
+    memset(split, 'a', sizeof(split));
+    memcpy(split, "[\"", 2);
+    memcpy(split + 62, "\xF0\x9F\x98\x80\"]", 6);
+    doc = jscone_parse_document(split, 68, &options);
+    TEST_ASSERT(doc != NULL && strcmp(doc->root->child->value.str + 60, "\xF0\x9F\x98\x80") == 0);
+    jscone_document_free(doc);
+    memcpy(split + 62, "\xF0\x9F\x98\"]", 5);
+    TEST_ASSERT(jscone_parse_document(split, 67, &options) == NULL);
+    TEST_ASSERT(jscone_last_error().code == JSCONE_ERROR_UTF8 && jscone_last_error().byte_offset == 65);
+
+    return TEST_SUCCESS;
+}
+
 END_TESTS()
@@ -70,4 +70,892 @@ TEST(find_complex)
     return TEST_SUCCESS;
 }
 
+TEST(path)
+{
+    const char* json = "{\"a/\": {\"x\": 1, \"\\u0022b\": {\"c\": true}}, \"a\": false}";
+    JsconeNode* result = jscone_parse(json, (u32)strlen(json));
+    TEST_ASSERT(result != NULL);
+
+    JsconePath* path = jscone_path_compile("/a\\//\\u0022b/c");
+    TEST_ASSERT(path != NULL && path->count == 3 && !path->relative);
+    TEST_ASSERT_STREQUAL(path->segments[1].name, "\"b");
+    TEST_ASSERT(jscone_path_eval(result, path) == jscone_find(result, "/a\\//\\u0022b/c"));
+    TEST_ASSERT(jscone_path_eval(result, path)->value.bool == JSCONE_TRUE);
+    TEST_ASSERT(jscone_path_eval(result->child->child, path) == NULL); // miss is just NULL
+    jscone_path_free(path);
+
+    /* search starts from the node given */
+    path = jscone_path_compile("a");
+    TEST_ASSERT(path != NULL && path->relative);
+    TEST_ASSERT(jscone_path_eval(result->child, path) == result->child->next);
+    jscone_path_free(path);
+
+    path = jscone_path_compile("/a/x");
+    TEST_ASSERT(jscone_path_eval(result, path) == NULL); // a is a bool
+    jscone_path_free(path);
+    jscone_free(result);
+
+    /* uses hash tables */
+    char wide[4 * 1024];
+    size_t length = (size_t)sprintf(wide, "{");
+    for(int i = 0; i < 100; i++)
+    {
+        length += (size_t)sprintf(wide + length, "\"k%d\": {\"v\": %d}, ", i, i);
+    }
+    length += (size_t)sprintf(wide + length, "\"end\": null}");
+
+    JsconeOptions options = {.block_size = 0, .flags = JSCONE_HASH_MEMBERS};
+    JsconeDocument* doc = jscone_parse_document(wide, (u32)length, &options);
+    path = jscone_path_compile("/k73/v");
+    TEST_ASSERT(jscone_path_eval(doc->root, path)->value.num == 73.0);
+    jscone_path_free(path);
+    path = jscone_path_compile("/k100/v");
+    TEST_ASSERT(jscone_path_eval(doc->root, path) == NULL);
+    jscone_path_free(path);
+    jscone_document_free(doc);
+
+    return TEST_SUCCESS;
+}
+
+TEST(symbols)
+{
+    JsconeSymbolTable* symbols = jscone_symbols_new();
+    TEST_ASSERT(symbols != NULL);
+    JsconeOptions options = {.block_size = 0, .flags = 0, .symbols = symbols};
+
+    const char* first = "[{\"id\": 1, \"tags\": [\"a\"]}, {\"id\": 2, \"n\\u0061me\": \"x\"}]";
+    const char* second = "{\"name\": {\"id\": 3}}";
+    JsconeDocument* doc1 = jscone_parse_document(first, (u32)strlen(first), &options);
+    JsconeDocument* doc2 = jscone_parse_document(second, (u32)strlen(second), &options);
+    TEST_ASSERT(doc1 != NULL && doc2 != NULL);
+
+    /* same name is the same pointer and symbol in every document */
+    JsconeNode* id1 = doc1->root->child->child;
+    JsconeNode* id2 = doc1->root->child->next->child;
+    JsconeNode* id3 = doc2->root->child->child;
+    TEST_ASSERT(id1->name == id2->name && id2->name == id3->name);
+    TEST_ASSERT(jscone_node_symbol(id1) != 0 && jscone_node_symbol(id1) == jscone_node_symbol(id3));
+    TEST_ASSERT(jscone_node_symbol(id1) == jscone_symbols_find(symbols, "id", 2));
+    TEST_ASSERT(doc2->root->child->name == id2->next->name); // escaped name
+    TEST_ASSERT_STREQUAL(doc2->root->child->name, "name");
+    TEST_ASSERT(jscone_symbols_find(symbols, "missing", 7) == 0);
+    TEST_ASSERT(jscone_node_symbol(doc1->root) == 0);
+
+    JsconePath* path = jscone_path_compile("/name/id");
+    TEST_ASSERT(jscone_path_intern(path, symbols) == JSCONE_SUCCESS);
+    TEST_ASSERT(path->segments[1].symbol == jscone_node_symbol(id1));
+    TEST_ASSERT(jscone_path_eval(doc2->root, path) == id3);
+    jscone_path_free(path);
+
+    /* lots of names */
+    char json[32 * 1024];
+    size_t length = (size_t)sprintf(json, "{");
+    for(int i = 0; i < 1000; i++)
+    {
+        length += (size_t)sprintf(json + length, "%s\"k%d\": %d", i ? ", " : "", i, i);
+    }
+    length += (size_t)sprintf(json + length, "}");
+    JsconeDocument* doc3 = jscone_parse_document(json, (u32)length, &options);
+    TEST_ASSERT(doc3 != NULL);
+    TEST_ASSERT(jscone_symbols_find(symbols, "k999", 4) == jscone_node_symbol(jscone_find(doc3->root, "/k999")));
+    TEST_ASSERT(jscone_symbols_find(symbols, "id", 2) == jscone_node_symbol(id1));
+
+    jscone_document_free(doc1);
+    jscone_document_free(doc2);
+    jscone_document_free(doc3);
+    jscone_symbols_free(symbols);
+
+    return TEST_SUCCESS;
+}
+
+TEST(parse_document)
+{
+    const char* json =
+        "{"
+            "\"people\": ["
+                "{\"name\": \"ada\", \"age\": 36},"
+                "{\"name\": \"alan\", \"age\": 41}"
+            "],"
+            "\"count\": 2"
+        "}";
+
+    /* tiny blocks to force the arena to grow */
+    JsconeOptions options = {.block_size = 1};
+    JsconeDocument* doc = jscone_parse_document(json, (u32)strlen(json), &options);
+    TEST_ASSERT(doc != NULL);
+    TEST_ASSERT(doc->root != NULL);
+    TEST_ASSERT(doc->root->type == JSCONE_OBJECT);
+
+    JsconeNode* found_node = jscone_find(doc->root, "/count");
+    TEST_ASSERT(found_node != NULL);
+    TEST_ASSERT(found_node->type == JSCONE_NUM);
+    TEST_ASSERT(found_node->value.num == 2.0);
+
+    found_node = jscone_find(doc->root, "/people");
+    TEST_ASSERT(found_node != NULL);
+    TEST_ASSERT(found_node->child != NULL && found_node->child->next != NULL);
+
+    found_node = jscone_find(found_node->child->next, "/name");
+    TEST_ASSERT(found_node != NULL);
+    TEST_ASSERT(found_node->type == JSCONE_STRING);
+    TEST_ASSERT_STREQUAL(found_node->value.str, "alan");
+
+    jscone_document_free(doc);
+
+    const char* bad_json = "{\"unterminated\": [1, 2}";
+    TEST_ASSERT(jscone_parse_document(bad_json, (u32)strlen(bad_json), NULL) == NULL);
+
+    return TEST_SUCCESS;
+}
+
+TEST(parse_insitu)
+{
+    char json[] = "{\"na\\u006de\": \"in\\tsitu\", \"list\": [\"a\", \"\\\"b\\\"\"]}";
+    char* json_end = json + sizeof(json);
+
+    JsconeDocument* doc = jscone_parse_insitu(json, (u32)strlen(json));
+    TEST_ASSERT(doc != NULL);
+
+    JsconeNode* found_node = jscone_find(doc->root, "/name");
+    TEST_ASSERT(found_node != NULL);
+    TEST_ASSERT_STREQUAL(found_node->value.str, "in\tsitu");
+
+    /* strings point into json */
+    TEST_ASSERT(found_node->name > json && found_node->name < json_end);
+    TEST_ASSERT(found_node->value.str > json && found_node->value.str < json_end);
+
+    found_node = jscone_find(doc->root, "/list");
+    TEST_ASSERT(found_node != NULL && found_node->child != NULL && found_node->child->next != NULL);
+    TEST_ASSERT_STREQUAL(found_node->child->value.str, "a");
+    TEST_ASSERT_STREQUAL(found_node->child->next->value.str, "\"b\"");
+
+    jscone_document_free(doc);
+
+    return TEST_SUCCESS;
+}
+
+TEST(parse_lazy_strings)
+{
+    const char* json = "{\"plain\": \"no escapes\", \"escaped\": \"tab\\there \\u0041\", \"bad\": \"\\q\"}";
+
+    JsconeOptions options = {.flags = JSCONE_LAZY_STRINGS};
+    JsconeDocument* doc = jscone_parse_document(json, (u32)strlen(json), &options);
+    TEST_ASSERT(doc != NULL);
+
+    /* zero copy view into json */
+    JsconeNode* found_node = jscone_find(doc->root, "/plain");
+    TEST_ASSERT(found_node != NULL);
+    TEST_ASSERT(found_node->flags == (JSCONE_NODE_ARENA | JSCONE_NODE_RAW));
+
+    size_t length = 0;
+    const char* string = jscone_document_string(doc, found_node, &length);
+    TEST_ASSERT(string == json + 11);
+    TEST_ASSERT(length == 10);
+    TEST_ASSERT(strncmp(string, "no escapes", length) == 0);
+
+    /* decoded on first access then cached */
+    found_node = jscone_find(doc->root, "/escaped");
+    TEST_ASSERT(found_node != NULL);
+    TEST_ASSERT(found_node->flags == (JSCONE_NODE_ARENA | JSCONE_NODE_RAW | JSCONE_NODE_ESCAPED));
+
+    string = jscone_document_string(doc, found_node, &length);
+    TEST_ASSERT(string != NULL);
+    TEST_ASSERT_STREQUAL(string, "tab\there A");
+    TEST_ASSERT(length == 10);
+    TEST_ASSERT(found_node->flags == JSCONE_NODE_ARENA && found_node->value.str == string);
+    TEST_ASSERT(jscone_document_string(doc, found_node, NULL) == string);
+
+    found_node = jscone_find(doc->root, "/bad");
+    TEST_ASSERT(jscone_document_string(doc, found_node, NULL) == NULL);
+
+    jscone_document_free(doc);
+
+    return TEST_SUCCESS;
+}
+
+TEST(parse_tape)
+{
+    const char* json =
+        "{"
+            "\"world\": {\"player_data\": [1.5, \"two\", true, null, {}]},"
+            "\"name\\/\": \"tape\""
+        "}";
+
+    JsconeTape* tape = jscone_parse_tape(json, (u32)strlen(json));
+    TEST_ASSERT(tape != NULL);
+    TEST_ASSERT(jscone_tape_type(tape, JSCONE_TAPE_ROOT) == JSCONE_OBJECT);
+    TEST_ASSERT(jscone_tape_name(tape, JSCONE_TAPE_ROOT) == NULL);
+
+    size_t index = jscone_tape_find(tape, JSCONE_TAPE_ROOT, "/world/player_data");
+    TEST_ASSERT(index != JSCONE_TAPE_NONE);
+    TEST_ASSERT(jscone_tape_type(tape, index) == JSCONE_ARRAY);
+    TEST_ASSERT_STREQUAL(jscone_tape_name(tape, index), "player_data");
+
+    JsconeType expected_types[5] = {JSCONE_NUM, JSCONE_STRING, JSCONE_BOOL, JSCONE_NULL, JSCONE_OBJECT};
+    index = jscone_tape_child(tape, index);
+    for(int i = 0; i < 5; i++)
+    {
+        TEST_ASSERT(index != JSCONE_TAPE_NONE);
+        TEST_ASSERT(jscone_tape_type(tape, index) == expected_types[i]);
+        TEST_ASSERT(jscone_tape_name(tape, index) == NULL);
+        if(i == 4)
+        {
+            TEST_ASSERT(jscone_tape_child(tape, index) == JSCONE_TAPE_NONE);
+        }
+        index = jscone_tape_next(tape, index);
+    }
+    TEST_ASSERT(index == JSCONE_TAPE_NONE);
+
+    index = jscone_tape_find(tape, JSCONE_TAPE_ROOT, "/world/player_data");
+    index = jscone_tape_child(tape, index);
+    TEST_ASSERT(jscone_tape_num(tape, index) == 1.5);
+    index = jscone_tape_next(tape, index);
+    size_t length = 0;
+    TEST_ASSERT_STREQUAL(jscone_tape_string(tape, index, &length), "two");
+    TEST_ASSERT(length == 3);
+    TEST_ASSERT(jscone_tape_bool(tape, jscone_tape_next(tape, index)) == JSCONE_TRUE);
+
+    index = jscone_tape_find(tape, JSCONE_TAPE_ROOT, "/name\\/");
+    TEST_ASSERT(index != JSCONE_TAPE_NONE);
+    TEST_ASSERT_STREQUAL(jscone_tape_string(tape, index, NULL), "tape");
+
+    TEST_ASSERT(jscone_tape_find(tape, JSCONE_TAPE_ROOT, "/world/missing") == JSCONE_TAPE_NONE);
+
+    jscone_tape_free(tape);
+
+    return TEST_SUCCESS;
+}
+
+TEST(parse_tape_nesting)
+{
+    /* containers ending one after another each add an entry, more than the tape's first guess */
+    u32 depth = 1000;
+    char* json = (char*)malloc(depth * 8 + 2);
+    u32 length = 0;
+    for(u32 i = 0; i < depth; i++)
+    {
+        memcpy(json + length, i % 2 ? "{\"a\": " : "[", i % 2 ? 6 : 1);
+        length += i % 2 ? 6 : 1;
+    }
+    json[length++] = '1';
+    for(u32 i = depth; i-- > 0;)
+    {
+        json[length++] = i % 2 ? '}' : ']';
+    }
+
+    JsconeTape* tape = jscone_parse_tape(json, length);
+    TEST_ASSERT(tape != NULL);
+    size_t index = JSCONE_TAPE_ROOT;
+    for(u32 i = 0; i < depth; i++)
+    {
+        TEST_ASSERT(jscone_tape_type(tape, index) == (i % 2 ? JSCONE_OBJECT : JSCONE_ARRAY));
+        TEST_ASSERT(jscone_tape_next(tape, index) == JSCONE_TAPE_NONE);
+        index = jscone_tape_child(tape, index);
+    }
+    TEST_ASSERT(jscone_tape_num(tape, index) == 1.0);
+    jscone_tape_free(tape);
+    free(json);
+
+    const char* ends = "[[[[]]], {\"a\": {\"b\": [{}]}}, [[1]]]";
+    tape = jscone_parse_tape(ends, (u32)strlen(ends));
+    TEST_ASSERT(tape != NULL);
+    index = jscone_tape_next(tape, jscone_tape_child(tape, JSCONE_TAPE_ROOT));
+    TEST_ASSERT(jscone_tape_type(tape, jscone_tape_child(tape, jscone_tape_find(tape, index, "/a/b"))) == JSCONE_OBJECT);
+    index = jscone_tape_next(tape, index);
+    TEST_ASSERT(jscone_tape_type(tape, jscone_tape_child(tape, jscone_tape_child(tape, index))) == JSCONE_NUM);
+    jscone_tape_free(tape);
+
+    return TEST_SUCCESS;
+}
+
+TEST(parse_compact)
+{
+    const char* json =
+        "{"
+            "\"world\": {\"player_data\": [1.5, \"two\", true, null, {}, 9007199254740993]},"
+            "\"name\\/\": \"compact\","
+            "\"last\": [[1], [2, [3]]]"
+        "}";
+
+    JsconeCompact* compact = jscone_parse_compact(json, strlen(json));
+    TEST_ASSERT(compact != NULL && compact->count == 17 && sizeof(JsconeCompactNode) == 16);
+    TEST_ASSERT(jscone_compact_type(compact, JSCONE_COMPACT_ROOT) == JSCONE_OBJECT);
+    TEST_ASSERT(jscone_compact_name(compact, JSCONE_COMPACT_ROOT) == NULL);
+    TEST_ASSERT(jscone_compact_len(compact, JSCONE_COMPACT_ROOT) == 3);
+
+    size_t index = jscone_compact_find(compact, JSCONE_COMPACT_ROOT, "/world/player_data");
+    TEST_ASSERT(index != JSCONE_COMPACT_NONE);
+    TEST_ASSERT(jscone_compact_type(compact, index) == JSCONE_ARRAY);
+    TEST_ASSERT_STREQUAL(jscone_compact_name(compact, index), "player_data");
+    TEST_ASSERT(jscone_compact_len(compact, index) == 6);
+
+    /* children are next to each other */
+    JsconeType expected_types[6] = {JSCONE_NUM, JSCONE_STRING, JSCONE_BOOL, JSCONE_NULL, JSCONE_OBJECT, JSCONE_INT};
+    size_t first = jscone_compact_child(compact, index, 0);
+    for(size_t i = 0; i < 6; i++)
+    {
+        TEST_ASSERT(jscone_compact_child(compact, index, i) == first + i);
+        TEST_ASSERT(jscone_compact_type(compact, first + i) == expected_types[i]);
+        TEST_ASSERT(jscone_compact_name(compact, first + i) == NULL);
+    }
+    TEST_ASSERT(jscone_compact_child(compact, index, 6) == JSCONE_COMPACT_NONE);
+    TEST_ASSERT(jscone_compact_len(compact, first + 4) == 0 && jscone_compact_child(compact, first + 4, 0) == JSCONE_COMPACT_NONE);
+
+    TEST_ASSERT(jscone_compact_num(compact, first) == 1.5);
+    size_t length = 0;
+    TEST_ASSERT_STREQUAL(jscone_compact_string(compact, first + 1, &length), "two");
+    TEST_ASSERT(length == 3);
+    TEST_ASSERT(jscone_compact_bool(compact, first + 2) == JSCONE_TRUE);
+    TEST_ASSERT(jscone_compact_int(compact, first + 5) == 9007199254740993);
+
+    index = jscone_compact_find(compact, JSCONE_COMPACT_ROOT, "name\\/");
+    TEST_ASSERT(index != JSCONE_COMPACT_NONE);
+    TEST_ASSERT_STREQUAL(jscone_compact_string(compact, index, NULL), "compact");
+
+    index = jscone_compact_find(compact, JSCONE_COMPACT_ROOT, "/last/1/1/0");
+    TEST_ASSERT(index != JSCONE_COMPACT_NONE && jscone_compact_num(compact, index) == 3.0);
+    TEST_ASSERT(jscone_compact_find(compact, JSCONE_COMPACT_ROOT, "/last/2") == JSCONE_COMPACT_NONE);
+    TEST_ASSERT(jscone_compact_find(compact, JSCONE_COMPACT_ROOT, "/world/missing") == JSCONE_COMPACT_NONE);
+
+    jscone_compact_free(compact);
+
+    TEST_ASSERT(jscone_parse_compact("[1, 2", 5) == NULL);
+    compact = jscone_parse_compact("[]", 2);
+    TEST_ASSERT(compact != NULL && compact->count == 1 && jscone_compact_len(compact, JSCONE_COMPACT_ROOT) == 0);
+    jscone_compact_free(compact);
+
+    return TEST_SUCCESS;
+}
+
+/* writes events out as compact json to check them */
+typedef struct
+{
+    char out[256];
+    size_t length;
+    unsigned char need_comma;
+    int stop_after; // fail on this event, -1 to never stop
+} TestEventLog;
+
+static int test_event_write(TestEventLog* log, const char* str, unsigned char value)
+{
+    if(log->need_comma && str[0] != '}' && str[0] != ']')
+    {
+        log->out[log->length++] = ',';
+    }
+    log->length += (size_t)sprintf(log->out + log->length, "%s", str);
+    log->need_comma = value;
+    return log->stop_after-- == 0 ? JSCONE_FAILURE : JSCONE_SUCCESS;
+}
+
+static int test_start_object(void* user) { return test_event_write((TestEventLog*)user, "{", JSCONE_FALSE); }
+static int test_end_object(void* user) { return test_event_write((TestEventLog*)user, "}", JSCONE_TRUE); }
+static int test_start_array(void* user) { return test_event_write((TestEventLog*)user, "[", JSCONE_FALSE); }
+static int test_end_array(void* user) { return test_event_write((TestEventLog*)user, "]", JSCONE_TRUE); }
+static int test_null(void* user) { return test_event_write((TestEventLog*)user, "null", JSCONE_TRUE); }
+static int test_boolean(void* user, unsigned char value) { return test_event_write((TestEventLog*)user, value ? "true" : "false", JSCONE_TRUE); }
+
+static int test_key(void* user, const char* name, size_t length)
+{
+    char buffer[64];
+    sprintf(buffer, "%.*s:", (int)length, name);
+    return test_event_write((TestEventLog*)user, buffer, JSCONE_FALSE);
+}
+
+static int test_string(void* user, const char* str, size_t length)
+{
+    char buffer[64];
+    sprintf(buffer, "'%.*s'", (int)length, str);
+    return test_event_write((TestEventLog*)user, buffer, JSCONE_TRUE);
+}
+
+static int test_number(void* user, double num)
+{
+    char buffer[64];
+    sprintf(buffer, "%g", num);
+    return test_event_write((TestEventLog*)user, buffer, JSCONE_TRUE);
+}
+
+TEST(parse_events)
+{
+    const char* json = "{\"a\": [1.5, \"t\\u0077o\", true, null, {}], \"b\\n\": {\"c\": false, \"d\": []}}";
+
+    JsconeHandler handler = {
+        .start_object = test_start_object,
+        .end_object = test_end_object,
+        .start_array = test_start_array,
+        .end_array = test_end_array,
+        .key = test_key,
+        .string = test_string,
+        .number = test_number,
+        .integer = NULL,
+        .boolean = test_boolean,
+        .null = test_null,
+    };
+
+    TestEventLog log = {.length = 0, .need_comma = JSCONE_FALSE, .stop_after = -1};
+    TEST_ASSERT(jscone_parse_events(json, (u32)strlen(json), &handler, &log) == JSCONE_SUCCESS);
+    log.out[log.length] = '\0';
+    TEST_ASSERT_STREQUAL(log.out, "{a:[1.5,'two',true,null,{}],b\n:{c:false,d:[]}}");
+
+    /* callback can stop it */
+    log = (TestEventLog){.length = 0, .need_comma = JSCONE_FALSE, .stop_after = 3};
+    TEST_ASSERT(jscone_parse_events(json, (u32)strlen(json), &handler, &log) == JSCONE_FAILURE);
+    log.out[log.length] = '\0';
+    TEST_ASSERT_STREQUAL(log.out, "{a:[1.5");
+
+    /* missing callbacks are skipped */
+    JsconeHandler empty = {0};
+    TEST_ASSERT(jscone_parse_events(json, (u32)strlen(json), &empty, NULL) == JSCONE_SUCCESS);
+    TEST_ASSERT(jscone_parse_events("[1, }", 5, &empty, NULL) == JSCONE_FAILURE);
+
+    return TEST_SUCCESS;
+}
+
+typedef struct
+{
+    int count;
+    int stop_after; // -1 to never stop
+} TestManyLog;
+
+static int test_many_callback(void* user, JsconeNode* root)
+{
+    TestManyLog* log = (TestManyLog*)user;
+    JsconeNode* id = jscone_find(root, "/id");
+    if(id == NULL || id->type != JSCONE_NUM || id->value.num != (double)log->count)
+    {
+        return JSCONE_FAILURE;
+    }
+
+    log->count++;
+    return log->count == log->stop_after ? JSCONE_FAILURE : JSCONE_SUCCESS;
+}
+
+TEST(parse_many)
+{
+    /* json lines */
+    char json[64 * 1024];
+    size_t length = 0;
+    for(int i = 0; i < 1000; i++)
+    {
+        length += (size_t)sprintf(json + length, "{\"id\": %d, \"tags\": [\"a}\", \"\\\"]\"]}\n", i);
+    }
+
+    for(unsigned int threads = 0; threads <= 4; threads++)
+    {
+        TestManyLog log = {.count = 0, .stop_after = -1};
+        TEST_ASSERT(jscone_parse_many(json, (u32)length, threads, test_many_callback, &log) == JSCONE_SUCCESS);
+        TEST_ASSERT(log.count == 1000);
+    }
+
+    /* callback stops it */
+    TestManyLog log = {.count = 0, .stop_after = 10};
+    TEST_ASSERT(jscone_parse_many(json, (u32)length, 2, test_many_callback, &log) == JSCONE_FAILURE);
+    TEST_ASSERT(log.count == 10);
+
+    /* documents before an invalid one are still given */
+    const char* invalid = "{\"id\": 0}{\"id\": 1} {\"id\" 2} {\"id\": 3}";
+    log = (TestManyLog){.count = 0, .stop_after = -1};
+    TEST_ASSERT(jscone_parse_many(invalid, (u32)strlen(invalid), 2, test_many_callback, &log) == JSCONE_FAILURE);
+    TEST_ASSERT(log.count == 2);
+
+    return TEST_SUCCESS;
+}
+
+static int test_nodes_equal(const JsconeNode* a, const JsconeNode* b)
+{
+    for(; a != NULL && b != NULL; a = a->next, b = b->next)
+    {
+        if(a->type != b->type || (a->name == NULL) != (b->name == NULL) || (a->name != NULL && strcmp(a->name, b->name) != 0))
+        {
+            return 0;
+        }
+        if((a->type == JSCONE_STRING && strcmp(a->value.str, b->value.str) != 0)
+        || (a->type == JSCONE_NUM && a->value.num != b->value.num)
+        || (a->type == JSCONE_INT && a->value.integer != b->value.integer)
+        || (a->type == JSCONE_BOOL && a->value.bool != b->value.bool))
+        {
+            return 0;
+        }
+        if(!test_nodes_equal(a->child, b->child) || (a->child != NULL && a->child->parent != a))
+        {
+            return 0;
+        }
+    }
+
+    return a == b;
+}
+
+TEST(parse_parallel)
+{
+    char json[64 * 1024];
+    size_t length = (size_t)sprintf(json, " [");
+    for(int i = 0; i < 1000; i++)
+    {
+        length += (size_t)sprintf(json + length, "%s{\"id\": %d, \"s\": \"a,]\\\"\", \"v\": [%d, [true, null]]}", i ? ", " : "", i, -i);
+    }
+    length += (size_t)sprintf(json + length, "]\n");
+
+    JsconeDocument* expected = jscone_parse_document(json, (u32)length, NULL);
+    TEST_ASSERT(expected != NULL);
+    for(unsigned int threads = 0; threads <= 4; threads++)
+    {
+        JsconeDocument* doc = jscone_parse_parallel(json, (u32)length, NULL, threads);
+        TEST_ASSERT(doc != NULL);
+        TEST_ASSERT(test_nodes_equal(doc->root, expected->root));
+        jscone_document_free(doc);
+    }
+    jscone_document_free(expected);
+
+    /* 0 is one thread per cpu, resolved before the ranges are counted so each thread still gets several */
+    unsigned int cpus = jscone_many_threads(0);
+    TEST_ASSERT(cpus >= 1 && jscone_many_threads(cpus) == cpus);
+    JsconeToken ranges[4 * JSCONE_PARALLEL_RANGES];
+    JsconeType type;
+    size_t capacity = (size_t)(cpus < 4 ? cpus : 4) * JSCONE_PARALLEL_RANGES;
+    TEST_ASSERT(jscone_parallel_split(json, length, ranges, capacity, &type) == capacity && type == JSCONE_ARRAY);
+
+    /* object root and empty roots */
+    const char* valid[3] = {"{\"a\": 1, \"b\": {\"c\": [2]}, \"d\": \"}\"}", "[]", " { } "};
+    for(int i = 0; i < 3; i++)
+    {
+        expected = jscone_parse_document(valid[i], (u32)strlen(valid[i]), NULL);
+        JsconeDocument* doc = jscone_parse_parallel(valid[i], (u32)strlen(valid[i]), NULL, 3);
+        TEST_ASSERT(doc != NULL);
+        TEST_ASSERT(test_nodes_equal(doc->root, expected->root));
+        jscone_document_free(doc);
+        jscone_document_free(expected);
+    }
+
+    const char* invalid[5] = {"[1, 2", "[1, 2} ", "[1, 2] 3", "1", "[1, [2}, 3]"};
+    for(int i = 0; i < 5; i++)
+    {
+        TEST_ASSERT(jscone_parse_parallel(invalid[i], (u32)strlen(invalid[i]), NULL, 2) == NULL);
+    }
+
+    return TEST_SUCCESS;
+}
+
+TEST(parse_file)
+{
+    const char* json = "{\"a\": \"plain\", \"b\": [\"esc\\u0061ped\", 2]}";
+    const char* path = "test_parse_file.json";
+    FILE* file = fopen(path, "wb");
+    TEST_ASSERT(file != NULL);
+    fputs(json, file);
+    fclose(file);
+
+    JsconeOptions options = {.block_size = 0, .flags = JSCONE_LAZY_STRINGS};
+    JsconeDocument* doc = jscone_parse_file(path, &options);
+    remove(path);
+    TEST_ASSERT(doc != NULL);
+    TEST_ASSERT(doc->file != NULL && doc->file_size == strlen(json));
+
+    size_t length;
+    const char* str = jscone_document_string(doc, doc->root->child, &length);
+    TEST_ASSERT(length == 5 && strncmp(str, "plain", length) == 0);
+    TEST_ASSERT(str > doc->file && str < doc->file + doc->file_size); // points into the file
+    str = jscone_document_string(doc, doc->root->child->next->child, &length);
+    TEST_ASSERT_STREQUAL(str, "escaped");
+    jscone_document_free(doc);
+
+    TEST_ASSERT(jscone_parse_file("does_not_exist.json", NULL) == NULL);
+
+    return TEST_SUCCESS;
+}
+
+TEST(stream)
+{
+    const char* json = "{\"a\": [1.5, \"t\\u0077o\", true, null, {}], \"b\\n\": {\"c\": false, \"d\": [-12e1]}}";
+    u32 length = (u32)strlen(json);
+
+    JsconeHandler handler = {
+        .start_object = test_start_object,
+        .end_object = test_end_object,
+        .start_array = test_start_array,
+        .end_array = test_end_array,
+        .key = test_key,
+        .string = test_string,
+        .number = test_number,
+        .integer = NULL,
+        .boolean = test_boolean,
+        .null = test_null,
+    };
+
+    /* split in two at every point and then one character at a time */
+    for(u32 split = 0; split <= length + 1; split++)
+    {
+        TestEventLog log = {.length = 0, .need_comma = JSCONE_FALSE, .stop_after = -1};
+        JsconeStream* stream = jscone_stream_new(&handler, &log);
+        TEST_ASSERT(stream != NULL);
+
+        if(split <= length)
+        {
+            TEST_ASSERT(jscone_stream_feed(stream, json, split) == JSCONE_SUCCESS);
+            TEST_ASSERT(jscone_stream_feed(stream, json + split, length - split) == JSCONE_SUCCESS);
+        }
+        else
+        {
+            for(u32 i = 0; i < length; i++)
+            {
+                TEST_ASSERT(jscone_stream_feed(stream, json + i, 1) == JSCONE_SUCCESS);
+            }
+        }
+        TEST_ASSERT(jscone_stream_finish(stream, NULL) == JSCONE_SUCCESS);
+
+        log.out[log.length] = '\0';
+        TEST_ASSERT_STREQUAL(log.out, "{a:[1.5,'two',true,null,{}],b\n:{c:false,d:[-120]}}");
+    }
+
+    /* building a tree */
+    JsconeStream* stream = jscone_stream_new(NULL, NULL);
+    TEST_ASSERT(jscone_stream_feed(stream, json, 20) == JSCONE_SUCCESS);
+    TEST_ASSERT(jscone_stream_feed(stream, json + 20, length - 20) == JSCONE_SUCCESS);
+    JsconeNode* root = NULL;
+    TEST_ASSERT(jscone_stream_finish(stream, &root) == JSCONE_SUCCESS);
+    TEST_ASSERT(root != NULL);
+
+    JsconeNode* found_node = jscone_find(root, "/b\n/d");
+    TEST_ASSERT(found_node != NULL);
+    TEST_ASSERT(found_node->type == JSCONE_ARRAY);
+    TEST_ASSERT(found_node->child->value.num == -120.0);
+    found_node = jscone_find(root, "/a");
+    TEST_ASSERT_STREQUAL(found_node->child->next->value.str, "two");
+    jscone_free(root);
+
+    /* incomplete or invalid */
+    const char* invalid[5] = {"{\"a\": [1, 2]", "{\"a\": \"b", "[tru", "[1] 2", "{\"a\": [1}}"};
+    for(int i = 0; i < 5; i++)
+    {
+        stream = jscone_stream_new(NULL, NULL);
+        jscone_stream_feed(stream, invalid[i], (u32)strlen(invalid[i]));
+        root = NULL;
+        TEST_ASSERT(jscone_stream_finish(stream, &root) == JSCONE_FAILURE);
+        TEST_ASSERT(root == NULL);
+    }
+
+    return TEST_SUCCESS;
+}
+
+TEST(trailing_commas)
+{
+    /* every way in must agree on the same input */
+    const char* json[10] = {"[1,]", "{\"a\": 1,}", "[[1,], 2]", "{\"a\": {\"b\": 1,}}", "[1, 2 , ]", "[,1]", "[1,,2]",
+                            "[1, 2]", "{\"a\": [1, 2], \"b\": {}}", "[[], {}, 3]"};
+    const u8 valid[10] = {0, 0, 0, 0, 0, 0, 0, 1, 1, 1};
+    for(int i = 0; i < 10; i++)
+    {
+        size_t length = strlen(json[i]);
+
+        JsconeNode* root = jscone_parse(json[i], length);
+        TEST_ASSERT((root != NULL) == valid[i]);
+        jscone_free(root);
+
+        JsconeDocument* doc = jscone_parse_document(json[i], length, NULL);
+        TEST_ASSERT((doc != NULL) == valid[i]);
+        jscone_document_free(doc);
+
+        JsconeTape* tape = jscone_parse_tape(json[i], length);
+        TEST_ASSERT((tape != NULL) == valid[i]);
+        jscone_tape_free(tape);
+
+        /* enough threads that every comma is a place to split */
+        doc = jscone_parse_parallel(json[i], length, NULL, 8);
+        TEST_ASSERT((doc != NULL) == valid[i]);
+        jscone_document_free(doc);
+
+        JsconeStream* stream = jscone_stream_new(NULL, NULL);
+        jscone_stream_feed(stream, json[i], length);
+        root = NULL;
+        TEST_ASSERT((jscone_stream_finish(stream, &root) == JSCONE_SUCCESS) == valid[i]);
+        jscone_free(root);
+    }
+
+    return TEST_SUCCESS;
+}
+
+TEST(cursor)
+{
+    const char* json =
+        "{"
+            "\"skipped\": {\"a\": [1, [2, \"]\"], {\"b\": \"}\"}]},"
+            "\"world\": {\"player_data\": [1.5, \"t\\u0077o\", true, null, 9007199254740993]},"
+            "\"name\\/\": \"cursor\""
+        "}";
+
+    JsconeCursor root;
+    TEST_ASSERT(jscone_cursor_init(&root, json, (u32)strlen(json)) == JSCONE_SUCCESS);
+    TEST_ASSERT(jscone_cursor_type(&root) == JSCONE_OBJECT);
+    TEST_ASSERT(jscone_cursor_name(&root, NULL) == NULL);
+
+    JsconeCursor cursor = root;
+    TEST_ASSERT(jscone_cursor_find(&cursor, "/world/player_data") == JSCONE_SUCCESS);
+    TEST_ASSERT(jscone_cursor_type(&cursor) == JSCONE_ARRAY);
+    size_t length = 0;
+    TEST_ASSERT(strncmp(jscone_cursor_name(&cursor, &length), "player_data", length) == 0);
+    TEST_ASSERT(length == 11);
+
+    JsconeType expected_types[5] = {JSCONE_NUM, JSCONE_STRING, JSCONE_BOOL, JSCONE_NULL, JSCONE_NUM};
+    TEST_ASSERT(jscone_cursor_first_element(&cursor) == JSCONE_SUCCESS);
+    for(int i = 0; i < 5; i++)
+    {
+        TEST_ASSERT(jscone_cursor_type(&cursor) == expected_types[i]);
+        TEST_ASSERT(jscone_cursor_name(&cursor, NULL) == NULL);
+        switch(i)
+        {
+            case 0:
+            {
+                f64 num = 0.0;
+                TEST_ASSERT(jscone_cursor_get_double(&cursor, &num) == JSCONE_SUCCESS);
+                TEST_ASSERT(num == 1.5);
+                int64_t integer;
+                TEST_ASSERT(jscone_cursor_get_int(&cursor, &integer) == JSCONE_FAILURE);
+                break;
+            }
+            case 1:
+            {
+                char* string = jscone_cursor_get_string(&cursor);
+                TEST_ASSERT_STREQUAL(string, "two");
+                free(string);
+                break;
+            }
+            case 2:
+            {
+                unsigned char value = JSCONE_FALSE;
+                TEST_ASSERT(jscone_cursor_get_bool(&cursor, &value) == JSCONE_SUCCESS);
+                TEST_ASSERT(value == JSCONE_TRUE);
+                break;
+            }
+            case 4:
+            {
+                int64_t integer = 0;
+                TEST_ASSERT(jscone_cursor_get_int(&cursor, &integer) == JSCONE_SUCCESS);
+                TEST_ASSERT(integer == 9007199254740993);
+                break;
+            }
+        }
+
+        TEST_ASSERT(jscone_cursor_next_element(&cursor) == (i < 4 ? JSCONE_SUCCESS : JSCONE_FAILURE));
+    }
+    TEST_ASSERT(jscone_cursor_type(&cursor) == JSCONE_NUM); // did not move past the end
+
+    /* escaped name */
+    cursor = root;
+    TEST_ASSERT(jscone_cursor_find_field(&cursor, "name/") == JSCONE_SUCCESS);
+    char* string = jscone_cursor_get_string(&cursor);
+    TEST_ASSERT_STREQUAL(string, "cursor");
+    free(string);
+
+    cursor = root;
+    TEST_ASSERT(jscone_cursor_find(&cursor, "/world/missing") == JSCONE_FAILURE);
+    TEST_ASSERT(jscone_cursor_find_field(&cursor, "a") == JSCONE_FAILURE); // not searched recursively
+    TEST_ASSERT(cursor.first == root.first);
+
+    /* only checked where the cursor goes */
+    const char* invalid = "[1, 2 3]";
+    TEST_ASSERT(jscone_cursor_init(&cursor, invalid, (u32)strlen(invalid)) == JSCONE_SUCCESS);
+    TEST_ASSERT(jscone_cursor_first_element(&cursor) == JSCONE_SUCCESS);
+    TEST_ASSERT(jscone_cursor_next_element(&cursor) == JSCONE_SUCCESS);
+    TEST_ASSERT(jscone_cursor_next_element(&cursor) == JSCONE_FAILURE);
+
+    return TEST_SUCCESS;
+}
+
+TEST(write)
+{
+    const char* json = "{\"a\": [1.5, -0, 0.1, 1e300, -2.5e-8, 9007199254740993, \"t\\\"\\\\\\n\\u0001\\u00e9\"], "
+                       "\"b\\t\": {\"c\": false, \"d\": [], \"e\": {}, \"f\": null}, \"long\": \"0123456789abcdef0123\\\"x\"}";
+    JsconeNode* root = jscone_parse(json, (u32)strlen(json));
+    TEST_ASSERT(root != NULL);
+
+    JsconeBuffer buf = {0};
+    TEST_ASSERT(jscone_write(root, &buf, NULL) == JSCONE_SUCCESS);
+    TEST_ASSERT_STREQUAL(buf.data, "{\"a\":[1.5,-0,0.1,1e+300,-2.5e-08,9007199254740993,\"t\\\"\\\\\\n\\u0001\xc3\xa9\"],"
+                                   "\"b\\t\":{\"c\":false,\"d\":[],\"e\":{},\"f\":null},\"long\":\"0123456789abcdef0123\\\"x\"}");
+    TEST_ASSERT(buf.length == strlen(buf.data));
+
+    /* compact and pretty both parse back to the same tree */
+    JsconeWriteOptions pretty = {.indent = 4};
+    for(int i = 0; i < 2; i++)
+    {
+        buf.length = 0;
+        TEST_ASSERT(jscone_write(root, &buf, i ? &pretty : NULL) == JSCONE_SUCCESS);
+        JsconeNode* copy = jscone_parse(buf.data, (u32)buf.length);
+        TEST_ASSERT(copy != NULL && test_nodes_equal(root, copy));
+        jscone_free(copy);
+    }
+    TEST_ASSERT(strstr(buf.data, "{\n    \"a\": [\n        1.5,\n") == buf.data);
+    TEST_ASSERT(strstr(buf.data, "\"d\": [],\n") != NULL);
+
+    /* just the node's value */
+    buf.length = 0;
+    TEST_ASSERT(jscone_write(jscone_find(root, "/b\t"), &buf, NULL) == JSCONE_SUCCESS);
+    TEST_ASSERT_STREQUAL(buf.data, "{\"c\":false,\"d\":[],\"e\":{},\"f\":null}");
+    jscone_free(root);
+
+    /* with as few digits as can be */
+    const f64 shortest[8] = {5e-324, 1e-323, 0.3, 1e23, 2.2250738585072014e-308, 1.7976931348623157e308, 9.5367431640625e-07, 123.456};
+    const char* texts[8] = {"5e-324", "1e-323", "0.3", "1e+23", "2.2250738585072014e-308", "1.7976931348623157e+308", "9.5367431640625e-07", "123.456"};
+    for(int i = 0; i < 8; i++)
+    {
+        buf.length = 0;
+        TEST_ASSERT(jscone_write_number(&buf, shortest[i]) == JSCONE_SUCCESS);
+        buf.data[buf.length] = '\0';
+        TEST_ASSERT_STREQUAL(buf.data, texts[i]);
+    }
+
+    /* doubles come back exactly */
+    JsconeNode* arr = jscone_node_create(NULL, JSCONE_ARRAY, (JsconeVal){0});
+    srand(1);
+    for(int i = 0; i < 1000; i++)
+    {
+        u64 bits = ((u64)rand() << 42) ^ ((u64)rand() << 21) ^ (u64)rand();
+        f64 num;
+        memcpy(&num, &bits, sizeof(num));
+        jscone_node_create(arr, JSCONE_NUM, (JsconeVal){.num = num != num ? 0.0 : num});
+    }
+    buf.length = 0;
+    TEST_ASSERT(jscone_write(arr, &buf, NULL) == JSCONE_SUCCESS);
+    JsconeNode* copy = jscone_parse(buf.data, (u32)buf.length);
+    TEST_ASSERT(copy != NULL);
+    for(JsconeNode *a = arr->child, *b = copy->child; a != NULL; a = a->next, b = b->next)
+    {
+        TEST_ASSERT(b != NULL && memcmp(&a->value.num, &b->value.num, sizeof(f64)) == 0);
+    }
+    jscone_free(copy);
+    jscone_free(arr);
+
+    const char* path = "test_write.json";
+    root = jscone_parse("[1, \"x\"]", 8);
+    TEST_ASSERT(jscone_write_file(root, path, NULL) == JSCONE_SUCCESS);
+    jscone_free(root);
+    JsconeDocument* doc = jscone_parse_file(path, NULL);
+    remove(path);
+    TEST_ASSERT(doc != NULL && doc->file_size == 7 && strncmp(doc->file, "[1,\"x\"]", 7) == 0);
+    jscone_document_free(doc);
+
+    /* lazy strings are copied as they are in the json until they're decoded, then escaped again */
+    const char* lazy = "{\"a\":\"x\\\"y\\\\z\\n\",\"b\":\"plain\"}";
+    JsconeOptions options = {.flags = JSCONE_LAZY_STRINGS};
+    for(int i = 0; i < 2; i++)
+    {
+        doc = jscone_parse_document(lazy, (u32)strlen(lazy), &options);
+        TEST_ASSERT(doc != NULL);
+        if(i == 1)
+        {
+            TEST_ASSERT_STREQUAL(jscone_document_string(doc, doc->root->child, NULL), "x\"y\\z\n");
+        }
+        buf.length = 0;
+        TEST_ASSERT(jscone_write(doc->root, &buf, NULL) == JSCONE_SUCCESS);
+        TEST_ASSERT_STREQUAL(buf.data, lazy);
+        copy = jscone_parse(buf.data, (u32)buf.length);
+        TEST_ASSERT(copy != NULL);
+        TEST_ASSERT_STREQUAL(copy->child->value.str, "x\"y\\z\n");
+        jscone_free(copy);
+        jscone_document_free(doc);
+    }
+    jscone_buffer_free(&buf);
+
+    return TEST_SUCCESS;
+}
+
 END_TESTS()
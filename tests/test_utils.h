@@ -26,6 +26,10 @@ else if(node->type == JSCONE_BOOL)                  \
 {                                                   \
     TEST_ASSERT(node->value.bool == val.bool);      \
 }                                                   \
+else if(node->type == JSCONE_INT)                   \
+{                                                   \
+    TEST_ASSERT(node->value.integer == val.integer);\
+}                                                   \
 else                                                \
 {                                                   \
     TEST_ASSERT(node->value.num == val.num);        \